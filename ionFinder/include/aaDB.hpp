@@ -31,6 +31,8 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <cstdint>
+#include <cstring>
 
 #include <utils.hpp>
 
@@ -42,6 +44,33 @@ namespace aaDB{
 	class AminoAcid;
 	class AADB;
 	
+	//!Index of N terminus in AADB mass table
+	size_t const N_TERM_SLOT = 256;
+	//!Index of C terminus in AADB mass table
+	size_t const C_TERM_SLOT = 257;
+	//!Number of entries in AADB mass table. One for each char and the two termini.
+	size_t const N_MASS_SLOTS = 258;
+	
+	//!Symbol and unmodified monoisotopic mass of one default AADB entry.
+	struct ResidueMass{
+		char symbol;
+		double mass;
+	};
+	
+	//!Default mass of N terminus
+	double constexpr DEFAULT_N_TERM_MASS = 1.00732;
+	//!Default mass of C terminus
+	double constexpr DEFAULT_C_TERM_MASS = 17.00325;
+	//!Default monoisotopic residue masses. Modification symbols have no mass until a static mod is added.
+	constexpr ResidueMass DEFAULT_RESIDUE_MASSES[] = {
+		{'A', 71.03712}, {'C', 103.00918}, {'D', 115.02694}, {'E', 129.0426},
+		{'F', 147.06841}, {'G', 57.02146}, {'H', 137.05891}, {'I', 113.08407},
+		{'K', 128.09496}, {'L', 113.08406}, {'M', 131.04049}, {'N', 114.04293},
+		{'O', 114.07931}, {'P', 97.05276}, {'Q', 128.05858}, {'R', 156.10111},
+		{'S', 87.03203}, {'T', 101.04768}, {'V', 99.06841}, {'W', 186.07931},
+		{'Y', 163.06333}, {'U', 150.95309}, {'*', 0}, {'@', 0}, {'&', 0}
+	};
+	
 	typedef std::map<std::string, AminoAcid> aminoAcidsDBType;
 	
 	class AminoAcid{
@@ -81,19 +110,42 @@ namespace aaDB{
 		
 	};//end of class
 
+	/**
+	 * Amino acid and terminal masses stored in a table indexed by residue char.
+	 * N_term and C_term are stored after the 256 char entries.
+	 * The string keyed functions look up the same table.
+	 */
 	class AADB{
 	private:
-		typedef aminoAcidsDBType::const_iterator itType;
-		aminoAcidsDBType aminoAcidsDB;
+		//!Unmodified mass of each slot
+		double _mass[N_MASS_SLOTS];
+		//!Static modification mass added to each slot
+		double _modification[N_MASS_SLOTS];
+		//!_mass + _modification for each slot
+		double _totalMass[N_MASS_SLOTS];
+		//!Does slot have a mass?
+		bool _exists[N_MASS_SLOTS];
+		//!Number of slots with a mass
+		size_t _size;
+		//!Hash of every symbol and mass
+		std::uint64_t _fingerprint;
 		
 		//modifiers
 		void initAADB();
 		bool readInModDB(std::string, aminoAcidsDBType&);
 		void addStaticMod(const aminoAcidsDBType&);
+		void setMass(size_t slot, double mass);
+		void applyMod(const AminoAcid&);
+		void updateFingerprint();
+		
+		static size_t getSlot(const std::string& symbol);
+		static const AADB& defaultAADB();
 		
 	public:
 		//constructor
-		AADB(){}
+		AADB(){
+			clear();
+		}
 		~AADB(){}
 		
 		//modifiers
@@ -104,12 +156,27 @@ namespace aaDB{
 		void clear();
 		
 		//properties
-		double calcMW(std::string sequence, bool addNTerm = true, bool addCTerm = true) const;
-		double getMW(std::string) const;
-		double getMW(char) const;
-		bool aaExists(std::string) const;
+		double calcMW(const std::string& sequence, bool addNTerm = true, bool addCTerm = true) const;
+		double getMW(const std::string&) const;
+		/**
+		 * Get mass of residue.
+		 * \param aa Residue.
+		 * \return Mass of \p aa or -1 if \p aa is not in AADB.
+		 */
+		double getMW(char aa) const{
+			size_t slot = (unsigned char)aa;
+			return _exists[slot] ? _totalMass[slot] : -1;
+		}
+		bool aaExists(const std::string&) const;
 		bool empty() const{
-			return aminoAcidsDB.empty();
+			return _size == 0;
+		}
+		/**
+		 * Get a hash of every symbol and mass in the AADB.
+		 * AADBs with the same fingerprint give the same masses for every sequence.
+		 */
+		std::uint64_t fingerprint() const{
+			return _fingerprint;
 		}
 	};//end of class
 	
@@ -0,0 +1,142 @@
+//
+// binaryCache.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_binaryCache_hpp
+#define ionfinder_binaryCache_hpp
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#include <scanSource.hpp>
+#include <scanIndex.hpp>
+#include <mappedFile.hpp>
+#include <indexedMsFile.hpp>
+#include <ms2Spectrum.hpp>
+
+namespace ms2 {
+
+    //! Extension appended to MS file names to get the name of their binary cache.
+    std::string const BINARY_CACHE_EXT = ".ifbin";
+    //! Incremented whenever the binary cache format changes so stale caches are ignored.
+    uint32_t const BINARY_CACHE_VERSION = 1;
+    char const BINARY_CACHE_MAGIC[8] = {'I', 'F', 'B', 'I', 'N', '\0', '\0', '\0'};
+    //! Written in native byte order so caches from a machine with a different byte order are rejected.
+    uint32_t const BINARY_CACHE_BYTE_ORDER = 0x01020304;
+
+    /**
+     * ScanSource for the binary cache of an MS file.
+     *
+     * The cache is written by the cache subcommand and holds the same data as the MS file
+     * in a form which can be mapped and read without parsing. It has three sections:
+     *   - A Header followed by a ScanHeader for each scan, sorted by scan number.
+     *   - Peak data. Each scan has a contiguous float32 m/z column followed by a float32 intensity column.
+     *   - A string table with the precursor m/z and precursor scan strings.
+     *
+     * Like the scan index sidecar, the cache is checked against the size and modification
+     * time of the MS file and ignored if the MS file has changed.
+     */
+    class BinaryCacheFile : public ScanSource {
+        typedef utils::msInterface::ScanIon ScanIon;
+        typedef utils::msInterface::PrecursorScan PrecursorScan;
+
+    public:
+        //! First bytes of the cache file.
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrder;
+            uint32_t fileType;
+            uint32_t reserved;
+            //! Size of the MS file when the cache was written.
+            uint64_t sourceSize;
+            //! Modification time of the MS file when the cache was written.
+            int64_t sourceMTime;
+            uint64_t nScans;
+            uint64_t stringsOffset;
+            uint64_t stringsSize;
+        };
+
+        //! Fixed size record for each scan.
+        struct ScanHeader {
+            uint64_t scanNum;
+            //! Byte offset of the m/z column. The intensity column follows immediately after.
+            uint64_t peaksOffset;
+            uint64_t nPeaks;
+            //! Retention time in minutes.
+            double rt;
+            double precursorIntensity;
+            int32_t charge;
+            //! Offset and length of the precursor m/z in the string table.
+            uint32_t mzOffset;
+            uint32_t mzLength;
+            //! Offset and length of the precursor scan in the string table.
+            uint32_t precursorScanOffset;
+            uint32_t precursorScanLength;
+            uint32_t reserved;
+        };
+
+    private:
+        std::string _fname;
+        MappedFile _file;
+        const Header* _header;
+        const ScanHeader* _scans;
+        const char* _strings;
+
+        std::string getString(uint32_t offset, uint32_t length) const;
+        static bool checkHeader(const Header& header, const std::string& fname);
+
+    public:
+        BinaryCacheFile() : _fname(""), _header(nullptr), _scans(nullptr), _strings(nullptr) {}
+
+        static std::string cacheName(const std::string& fname) {
+            return fname + BINARY_CACHE_EXT;
+        }
+        static bool isCurrent(const std::string& fname);
+        static bool write(const std::string& fname, const std::string& ofname);
+
+        bool read(const std::string& fname) override;
+        bool getScan(size_t scanNum, ms2::Spectrum& scan) const override;
+
+        //! The mapping is made of clean file pages which the kernel can drop, so nothing is counted.
+        size_t estimateMemory(const std::string&) const override {
+            return 0;
+        }
+        size_t memoryUsage() const override {
+            return 0;
+        }
+        size_t size() const {
+            return _header ? (size_t)_header->nScans : 0;
+        }
+    };
+}
+
+#endif //ionfinder_binaryCache_hpp
@@ -0,0 +1,53 @@
+//
+// binaryData.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_binaryData_hpp
+#define ionfinder_binaryData_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+#include <utils.hpp>
+
+namespace ms2 {
+
+    //! Byte order of encoded binary arrays.
+    enum class ByteOrder {LITTLE_ENDIAN_ORDER, BIG_ENDIAN_ORDER};
+
+    ByteOrder hostByteOrder();
+    bool base64Decode(const char* begin, const char* end, std::string& out);
+    bool zlibDecompress(const std::string& in, std::string& out, size_t expectedSize = 0);
+    bool decodeFloats(const std::string& bytes, int precision, ByteOrder byteOrder, std::vector<double>& out);
+    bool decodeBinaryArray(const char* begin, const char* end, int precision, ByteOrder byteOrder,
+                           bool zlib, std::vector<double>& out, size_t expectedLength = 0);
+}
+
+#endif //ionfinder_binaryData_hpp
@@ -30,23 +30,31 @@
 
 #include <iostream>
 #include <fstream>
+#include <functional>
 
 #include <paramsBase.hpp>
 #include <scanData.hpp>
 #include <utils.hpp>
+#include <gzipStream.hpp>
 
 namespace Dtafilter{
 	class Scan;
 	
 	std::string const REVERSE_MATCH = "reverse_";
+
+	//! Called for each scan read from an input file. Return false to stop reading.
+	typedef std::function<bool(Dtafilter::Scan&)> ScanCallback;
 	
 	bool readFilterFile(const std::string& fname, const std::string& sampleName,
 						std::vector<Dtafilter::Scan>& scans,
 						bool skipReverse = false, int modFilter = 1);
+	bool readFilterFile(const std::string& fname, const std::string& sampleName,
+						const ScanCallback& callback,
+						bool skipReverse = false, int modFilter = 1);
 	
 	class Scan : public scanData::Scan{
 		friend bool readFilterFile(const std::string&, const std::string&,
-								   std::vector<Dtafilter::Scan>&,
+								   const ScanCallback&,
 								   bool, int);
 	public:
 		enum class MatchDirection{FORWARD, REVERSE};
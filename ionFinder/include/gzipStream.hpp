@@ -0,0 +1,120 @@
+//
+// gzipStream.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_gzipStream_hpp
+#define ionfinder_gzipStream_hpp
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <istream>
+#include <fstream>
+#include <streambuf>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+
+namespace gzip {
+
+    //! Extension of gzip compressed files.
+    std::string const GZIP_EXT = ".gz";
+    //! Bytes of decompressed data in each chunk passed from the decompression thread to the reader.
+    size_t const CHUNK_SIZE = 1024 * 1024;
+    //! Maximum number of decompressed chunks waiting to be read.
+    size_t const MAX_QUEUED_CHUNKS = 4;
+    //! Bytes of already read data kept so the reader can seek backwards a short distance.
+    size_t const SEEK_BACK_SIZE = 64 * 1024;
+
+    bool isCompressed(const std::string& fname);
+    uint64_t uncompressedSize(const std::string& fname);
+    std::string findFile(const std::string& fname);
+    bool readFile(const std::string& fname, std::string& data);
+
+    /**
+     * Read only stream buffer which decompresses a gzip file on a background thread. <br>
+     * The decompression thread stays up to MAX_QUEUED_CHUNKS chunks ahead of the reader.
+     * The last SEEK_BACK_SIZE bytes which were read are kept so positions returned by
+     * tellg can be passed to seekg as long as they are not too far behind the current position.
+     * If the file can not be decompressed, underflow returns eof and failed() is true.
+     */
+    class StreamBuf : public std::streambuf {
+    private:
+        std::string _fname;
+        std::thread _thread;
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::string> _chunks;
+        bool _done;
+        bool _failed;
+        bool _stop;
+
+        //! Data which can currently be read. The end of the previous window is kept at the beginning.
+        std::string _window;
+        //! Offset in the decompressed file of the first byte in _window.
+        uint64_t _windowOffset;
+
+        void decompress();
+        bool push(std::string& chunk);
+
+    protected:
+        int_type underflow() override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                         std::ios_base::openmode which = std::ios_base::in) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+
+    public:
+        explicit StreamBuf(const std::string& fname);
+        StreamBuf(const StreamBuf&) = delete;
+        StreamBuf& operator = (const StreamBuf&) = delete;
+        ~StreamBuf() override;
+
+        bool failed() const;
+    };
+
+    /**
+     * Input file stream which reads gzip compressed files transparently.
+     * Files which do not begin with the gzip magic bytes are read with a std::filebuf.
+     */
+    class IfStream : public std::istream {
+    private:
+        std::unique_ptr<std::streambuf> _buf;
+        bool _compressed;
+    public:
+        explicit IfStream(const std::string& fname);
+        bool isCompressed() const {
+            return _compressed;
+        }
+        //! Did decompression of a compressed file fail before the end of the file?
+        bool failed() const {
+            return _compressed && static_cast<const StreamBuf*>(_buf.get())->failed();
+        }
+    };
+}
+
+#endif //ionfinder_gzipStream_hpp
@@ -0,0 +1,116 @@
+//
+// indexedMsFile.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_indexedMsFile_hpp
+#define ionfinder_indexedMsFile_hpp
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+#include <scanSource.hpp>
+#include <scanIndex.hpp>
+#include <binaryData.hpp>
+#include <gzipStream.hpp>
+#include <ms2Spectrum.hpp>
+
+namespace ms2 {
+
+    //! Bytes of scan text read before the scans are decoded in parallel. Up to two chunks are in memory at once.
+    size_t const DECODE_CHUNK_BYTES = 64 * 1024 * 1024;
+
+    /**
+     * ScanSource which uses a ScanIndex to read only the bytes of requested scans.
+     * Scans are parsed from their position in the file each time they are requested,
+     * so load time and memory use are proportional to the number of scans used.
+     */
+    class IndexedMsFile : public ScanSource {
+    public:
+        typedef utils::msInterface::ScanIon ScanIon;
+        typedef utils::msInterface::PrecursorScan PrecursorScan;
+        //! Called for each scan by forEachScan. Return false to stop iterating.
+        typedef std::function<bool(const ScanIndex::Entry&, const PrecursorScan&,
+                                   const std::vector<ScanIon>&)> ScanCallback;
+
+    private:
+
+        //! A scan which was decoded when the file was read.
+        struct DecodedScan {
+            PrecursorScan precursor;
+            std::vector<ScanIon> ions;
+        };
+
+        std::string _fname;
+        ScanIndex _index;
+        //! Scans decoded in read. Not modified after read returns.
+        std::map<size_t, DecodedScan> _decoded;
+        //! Number of threads used to build the index and decode scans in read.
+        unsigned int _nThread;
+        //! Read and write the index sidecar instead of building the index on every run.
+        bool _useSidecar;
+        //! Is the file gzip compressed?
+        bool _compressed;
+        //! Decompressed contents of compressed files.
+        std::string _data;
+
+        bool readIndex(const std::string& fname, DecodeThreads& threads);
+        bool openFile(std::ifstream& inF) const;
+        bool readBlock(std::ifstream& inF, const ScanIndex::Entry& entry, std::string& block) const;
+        bool readBlock(const ScanIndex::Entry& entry, std::string& block) const;
+        bool parseScan(const ScanIndex::Entry& entry, const std::string& block,
+                       PrecursorScan& precursor, std::vector<ScanIon>& ions) const;
+        static bool parseMzXML(const std::string& block, PrecursorScan& precursor, std::vector<ScanIon>& ions);
+        static bool parseMzML(const std::string& block, PrecursorScan& precursor, std::vector<ScanIon>& ions);
+        static void makeIons(const std::vector<double>& mz, const std::vector<double>& intensity,
+                             std::vector<ScanIon>& ions);
+
+    public:
+        explicit IndexedMsFile(unsigned int nThread = 1, bool useSidecar = true)
+            : _fname(""), _nThread(std::max(1u, nThread)), _useSidecar(useSidecar), _compressed(false) {}
+
+        static bool parseMs2(const char* begin, const char* end, PrecursorScan& precursor, std::vector<ScanIon>& ions);
+
+        bool read(const std::string& fname) override;
+        bool read(const std::string& fname, const std::vector<size_t>& scans) override;
+        bool getScan(size_t scanNum, ms2::Spectrum& scan) const override;
+        bool forEachScan(const ScanCallback& callback) const;
+        size_t estimateMemory(const std::string& fname) const override;
+        size_t memoryUsage() const override;
+        const ScanIndex& getIndex() const {
+            return _index;
+        }
+    };
+}
+
+#endif //ionfinder_indexedMsFile_hpp
@@ -0,0 +1,78 @@
+//
+// aaDBCache.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef aaDBCache_hpp
+#define aaDBCache_hpp
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include <aaDB.hpp>
+#include <dtafilter.hpp>
+#include <ionFinder/params.hpp>
+#include <ionFinder/threadPool.hpp>
+
+namespace IonFinder{
+
+    class AADBCache;
+
+    /**
+     * Amino acid masses for each sample directory, shared by all worker threads. <br><br>
+     *
+     * In DTAFilter input mode the masses for a scan are read from the sequest.params file
+     * in the same directory as its MS file. Otherwise every scan uses the same masses.
+     * build() reads every directory up front so that workers only look masses up.
+     * Directories which were not built are read the first time they are requested.
+     * Entries are never removed, so references returned by get() stay valid for the life of the cache.
+     */
+    class AADBCache{
+    private:
+        const IonFinder::Params& _pars;
+        std::map<std::string, aaDB::AADB> _masses;
+        mutable std::mutex mutex;
+
+        std::string getKey(const Dtafilter::Scan& scan) const;
+
+    public:
+        explicit AADBCache(const IonFinder::Params& pars) : _pars(pars) {}
+        AADBCache(const AADBCache&) = delete;
+        AADBCache& operator = (const AADBCache&) = delete;
+
+        void build(const std::vector<Dtafilter::Scan>& scans, ThreadPool& pool);
+        const aaDB::AADB& get(const Dtafilter::Scan& scan);
+
+        size_t size() const{
+            std::lock_guard<std::mutex> lock(mutex);
+            return _masses.size();
+        }
+    };
+}
+
+#endif /* aaDBCache_hpp */
@@ -0,0 +1,114 @@
+//
+// boundedQueue.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef boundedQueue_hpp
+#define boundedQueue_hpp
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstddef>
+
+namespace IonFinder{
+
+    template<typename T> class BoundedQueue;
+
+    /**
+     * Thread safe FIFO queue with a maximum size. <br><br>
+     *
+     * push() blocks while the queue is full and pop() blocks while it is empty,
+     * so a slow consumer limits how far ahead its producers can get.
+     * Once the queue is closed, push() fails and pop() fails after the remaining items are consumed.
+     */
+    template<typename T>
+    class BoundedQueue{
+    private:
+        std::deque<T> _items;
+        size_t _capacity;
+        bool _closed;
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+
+    public:
+        explicit BoundedQueue(size_t capacity){
+            _capacity = std::max<size_t>(capacity, 1);
+            _closed = false;
+        }
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator = (const BoundedQueue&) = delete;
+
+        /**
+         * Add \p item to the back of the queue, waiting for space if the queue is full.
+         * \param item Item to add.
+         * \return false if the queue was closed.
+         */
+        bool push(T item){
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [this]() -> bool { return _closed || _items.size() < _capacity; });
+            if(_closed) return false;
+            _items.push_back(std::move(item));
+            notEmpty.notify_one();
+            return true;
+        }
+
+        /**
+         * Remove the item at the front of the queue, waiting for one if the queue is empty.
+         * \param item Set to the removed item.
+         * \return false if the queue is closed and empty.
+         */
+        bool pop(T& item){
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this]() -> bool { return _closed || !_items.empty(); });
+            if(_items.empty()) return false;
+            item = std::move(_items.front());
+            _items.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        //! No more items will be added. Items already in the queue can still be removed.
+        void close(){
+            std::lock_guard<std::mutex> lock(mutex);
+            _closed = true;
+            notEmpty.notify_all();
+            notFull.notify_all();
+        }
+
+        //! Close the queue and discard any items in it.
+        void cancel(){
+            std::lock_guard<std::mutex> lock(mutex);
+            _closed = true;
+            _items.clear();
+            notEmpty.notify_all();
+            notFull.notify_all();
+        }
+    };
+}
+
+#endif /* boundedQueue_hpp */
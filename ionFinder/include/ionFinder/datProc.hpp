@@ -30,6 +30,7 @@
 
 #include <cassert>
 #include <map>
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <iostream>
@@ -41,10 +42,20 @@
 #include <set>
 #include <cmath>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <iterator>
 
 #include <constants.hpp>
 #include <ionFinder/ionFinder.hpp>
 #include <ionFinder/params.hpp>
+#include <ionFinder/scanScheduler.hpp>
+#include <ionFinder/prefetcher.hpp>
+#include <ionFinder/textBuffer.hpp>
+#include <ionFinder/progressReporter.hpp>
+#include <ionFinder/threadPool.hpp>
+#include <ionFinder/aaDBCache.hpp>
 #include <dtafilter.hpp>
 #include <fastaFile.hpp>
 #include <peptide.hpp>
@@ -64,34 +75,51 @@ namespace IonFinder{
 	const std::string ION_TYPES_STR [] = {"frag", "det", "amb", "detNL", "artNL"};
 	const std::string CONTAINS_CIT_STR [] {"false", "ambiguous", "likely", "true"};
 	
-	//!Progress bar sleep time in seconds
-	int const PROGRESS_SLEEP_TIME = 1;
-	//!Max iterations of progress bar loop with no progress before quitting
-	int const MAX_PROGRESS_ITTERATIONS = 600;
-	//!Progress bar width in chars
-	int const PROGRESS_BAR_WIDTH = 60;
+	//!Number of rows formatted together by one thread in printPeptideStats
+	size_t const OUTPUT_CHUNK_ROWS = 4096;
 
 	bool findFragmentsParallel(std::vector<Dtafilter::Scan>&,
 							   std::vector<PeptideNamespace::Peptide>&,
-							   const IonFinder::Params&);
+							   const IonFinder::Params&,
+							   ThreadPool&);
 
     void findFragments_(std::vector<Dtafilter::Scan>& scans,
                         size_t beg, size_t end,
                         std::vector<PeptideNamespace::Peptide>& peptides,
                         const IonFinder::Params& pars,
-                        bool* success, std::atomic<size_t>& scansIndex);
+                        bool* success, ProgressCounter& progress);
 
     void findFragments_threadSafe(std::vector<Dtafilter::Scan>& scans,
                                   size_t beg, size_t end,
                                   ms2::MsInterface& msInterface,
+                                  PeptideNamespace::LadderCache& ladderCache,
+                                  AADBCache& aadbCache,
                                   std::vector<PeptideNamespace::Peptide>& peptides,
                                   const IonFinder::Params& pars,
-                                  bool* success, std::atomic<size_t>& scansIndex);
+                                  bool* success, ProgressCounter& progress);
+
+    void findFragments_threadSafe(std::vector<Dtafilter::Scan>& scans,
+                                  const std::vector<size_t>& indices,
+                                  ms2::MsInterface& msInterface,
+                                  PeptideNamespace::LadderCache& ladderCache,
+                                  AADBCache& aadbCache,
+                                  std::vector<PeptideNamespace::Peptide>& peptides,
+                                  const IonFinder::Params& pars,
+                                  bool* success, ProgressCounter& progress);
+
+    void findFragmentsWorker(std::vector<Dtafilter::Scan>& scans,
+                             ScanScheduler& scheduler, unsigned int workerIndex,
+                             ms2::MsInterface& msInterface, Prefetcher& prefetcher,
+                             PeptideNamespace::LadderCache& ladderCache,
+                             AADBCache& aadbCache,
+                             std::vector<std::vector<PeptideNamespace::Peptide> >& batchPeptides,
+                             const IonFinder::Params& pars,
+                             bool* success, ProgressCounter& progress,
+                             WorkerStats& stats);
+
+    void printWorkerStats(const std::vector<WorkerStats>& stats, double wallTime,
+                          bool verbose, std::ostream& out = std::cout);
 
-	void findFragmentsProgress(std::atomic<size_t>& scansIndex, size_t count,
-							   const std::string& message,
-							   int sleepTime = PROGRESS_SLEEP_TIME);
-	
 	bool findFragments(std::vector<Dtafilter::Scan>& scans,
 					   std::vector<PeptideNamespace::Peptide>& peptides,
 					   IonFinder::Params& pars);
@@ -99,32 +127,71 @@ namespace IonFinder{
 	bool analyzeSequences(std::vector<Dtafilter::Scan>&,
 						  const std::vector<PeptideNamespace::Peptide>&,
 						  std::vector<PeptideStats>&,
-						  const IonFinder::Params&);
+						  const IonFinder::Params&,
+						  ThreadPool&);
+
+	void initAminoAcidMasses(const Dtafilter::Scan& scan,
+	                         const IonFinder::Params& pars,
+	                         aaDB::AADB& aminoAcidMasses);
+
+	void labelScan(Dtafilter::Scan& scan,
+	               ms2::MsInterface& msInterface,
+	               PeptideNamespace::LadderCache& ladderCache,
+	               const aaDB::AADB& aminoAcidMasses,
+	               PeptideNamespace::Peptide& peptide,
+	               ms2::Spectrum& spectrum,
+	               const IonFinder::Params& pars);
+
+	void analyzePeptide(Dtafilter::Scan& scan,
+	                    const PeptideNamespace::Peptide& peptide,
+	                    const utils::FastaFile* seqFile,
+	                    const IonFinder::Params& pars,
+	                    std::vector<PeptideStats>& peptideStats,
+	                    int& nSeqNotFound);
 
 	bool printFragmentIntensities(const std::vector<PeptideStats>&, std::string, std::string = "");
 	
 	bool printPeptideStats(const std::vector<PeptideStats>&,
-						   const IonFinder::Params&);
+						   const IonFinder::Params&,
+						   ThreadPool&);
+
+	void printPeptideStatsHeader(std::ostream& outF, const IonFinder::Params& pars);
 	
 	bool allignSeq(const std::string& ref, const std::string& query, size_t& beg, size_t& end);
 
+	/**
+	 * Fragment ion found in a spectrum. <br>
+	 * Ions are identified by their packed PeptideNamespace::IonKey.
+	 * The label string is only made by PeptideStats::getIonStr when it is printed.
+	 */
 	class FragmentIon{
 	private:
-		std::string _ionStr;
+		PeptideNamespace::IonKey _key;
+		//!First and last residue of ion in peptide sequence
+		size_t _begin, _end;
 		double _intensity;
 	public:
-		FragmentIon() { _ionStr = ""; _intensity = 0.0; }
-		FragmentIon(std::string ionStr, double intensity) {
-			_ionStr = std::move(ionStr); _intensity = intensity;
-        }
+		FragmentIon() { _begin = 0; _end = 0; _intensity = 0.0; }
+		explicit FragmentIon(const PeptideNamespace::FragmentIon& ion) {
+			_key = ion.getKey();
+			_begin = ion.getBegin();
+			_end = ion.getEnd();
+			_intensity = ion.getFoundIntensity();
+		}
 
 		//! less than for std::set
 		bool operator < (const FragmentIon& rhs) const {
-            return _ionStr < rhs._ionStr;
-        }
-		std::string getIonStr() const {
-            return _ionStr;
+            return _key < rhs._key;
         }
+		const PeptideNamespace::IonKey& getKey() const {
+			return _key;
+		}
+		size_t getBegin() const {
+			return _begin;
+		}
+		size_t getEnd() const {
+			return _end;
+		}
         double getIntensity() const {
             return _intensity;
         }
@@ -135,10 +202,19 @@ namespace IonFinder{
 		friend bool analyzeSequences(std::vector<Dtafilter::Scan>&,
 									 const std::vector<PeptideNamespace::Peptide>&,
 									 std::vector<PeptideStats>&,
-									 const IonFinder::Params&);
+									 const IonFinder::Params&,
+									 ThreadPool&);
 		
 		friend bool printPeptideStats(const std::vector<PeptideStats>&,
-									  const IonFinder::Params&);
+									  const IonFinder::Params&,
+									  ThreadPool&);
+
+		friend void analyzePeptide(Dtafilter::Scan&,
+								   const PeptideNamespace::Peptide&,
+								   const utils::FastaFile*,
+								   const IonFinder::Params&,
+								   std::vector<PeptideStats>&,
+								   int&);
 		enum class IonType{
 			//!All fragments identified
 			FRAG,
@@ -155,6 +231,10 @@ namespace IonFinder{
 		};
 
 		enum class ContainsCitType {FALSE = 0, AMBIGUOUS = 1, LIKELY = 2, TRUE = 3};
+
+		friend void printPeptideStatsRow(TextBuffer&, const PeptideStats&,
+										 const std::vector<IonType>&,
+										 const IonFinder::Params&);
 	private:
 		
 		typedef std::set<IonFinder::FragmentIon> IonStrings;
@@ -183,11 +263,16 @@ namespace IonFinder{
 		size_t modIndex;
 
 		//!unique identifier of peptide
-		unsigned int _id;
+		std::uint64_t _id;
 		
 		//!Positions of modified residues on protein
 		std::string modResidues;
 		
+		//!Dynamic modification symbol of each residue or '\0' if residue is not modified
+		std::string residueMods;
+		//!Mass of a single neutral loss
+		double nlMass;
+		
 		//!pointer to corresponding scan object
 		Dtafilter::Scan* _scan;
 		
@@ -200,7 +285,7 @@ namespace IonFinder{
 	
 	public:		
 		PeptideStats(){
-			_scan = new Dtafilter::Scan;
+			_scan = nullptr;
 			initStats();
 			_fragDelim = FRAG_DELIM;
             containsCit = ContainsCitType::FALSE;
@@ -212,11 +297,12 @@ namespace IonFinder{
 			fullSequence = "";
 			charge = 0;
 			mass = 0;
+			nlMass = 0;
 			_id = -1;
 		}
 		explicit PeptideStats(const PeptideNamespace::Peptide& p){
 			//PeptideStats data
-			_scan = new Dtafilter::Scan;
+			_scan = nullptr;
 			_fragDelim = FRAG_DELIM;
             containsCit = ContainsCitType::FALSE;
             thisContainsCit = ContainsCitType::FALSE;
@@ -231,9 +317,12 @@ namespace IonFinder{
 			modLocs.clear();
 			modLocs.insert(modLocs.begin(), p.getModLocs().begin(), p.getModLocs().end());
 			modIndex = std::string::npos;
+			residueMods = p.getResidueMods();
+			nlMass = p.getNLMass();
 			_id = p.getID();
 		}
 		PeptideStats(const PeptideStats&);
+		PeptideStats(PeptideStats&&) = default;
 
 		~PeptideStats() = default;
 
@@ -247,15 +336,23 @@ namespace IonFinder{
         double fragmentIntensity(IonType, double min, double max = std::numeric_limits<double>::max()) const;
         double calcIntCO(double fractionArtifact) const;
         void printFragmentStats(std::ostream& out) const;
+        std::string getIonStr(const IonFinder::FragmentIon&) const;
 
 		//modifiers
 		PeptideStats& operator = (const PeptideStats&);
+		PeptideStats& operator = (PeptideStats&&) = default;
 		void addSeq(const PeptideNamespace::FragmentIon&, size_t modLoc, const std::string&);
 		static std::string ionTypeToStr(const IonType&);
 		static std::string containsCitToStr(const ContainsCitType&);
 		void consolidate(const PeptideStats&);
 	};
 	
+	std::vector<PeptideStats::IonType> printedIonTypes(const IonFinder::Params& pars);
+
+	void printPeptideStatsRow(TextBuffer& outF, const PeptideStats& stat,
+							  const std::vector<PeptideStats::IonType>& ionTypes,
+							  const IonFinder::Params& pars);
+
 	inline PeptideStats::IonType operator++(PeptideStats::IonType& x ){
 		return x = (PeptideStats::IonType)(((int)(x) + 1));
 	}
@@ -28,15 +28,21 @@
 #ifndef inputFiles_hpp
 #define inputFiles_hpp
 
+#include <cassert>
+#include <map>
+#include <cstdlib>
+
 #include <dtafilter.hpp>
 #include <ionFinder/params.hpp>
+#include <ionFinder/threadPool.hpp>
 #include <scanData.hpp>
 #include <utils.hpp>
-#include <tsvFile.hpp>
+#include <gzipStream.hpp>
 #include <tsv_constants.hpp>
 
 namespace Dtafilter{
 	bool readFilterFiles(const IonFinder::Params&, std::vector<Dtafilter::Scan>&);
+	bool readFilterFiles(const IonFinder::Params&, const Dtafilter::ScanCallback&);
 }
 
 namespace IonFinder{
@@ -49,6 +55,11 @@ namespace IonFinder{
 	
 	bool readInputTsv(const std::string& ifname, std::vector<Dtafilter::Scan>&scans,
 					  bool skipReverse = false, int modFilter = 1);
+	bool readInputTsv(const std::string& ifname, const Dtafilter::ScanCallback& callback,
+					  bool skipReverse = false, int modFilter = 1);
+	bool readInputFiles(const IonFinder::Params& pars, const Dtafilter::ScanCallback& callback);
+	bool readInputFiles(const IonFinder::Params& pars, std::vector<Dtafilter::Scan>& scans,
+						IonFinder::ThreadPool& pool);
 }
 
 #endif /* inputFiles_hpp */
@@ -32,6 +32,8 @@
 #include <dtafilter.hpp>
 #include <ionFinder/inputFiles.hpp>
 #include <ionFinder/datProc.hpp>
+#include <ionFinder/stream.hpp>
+#include <ionFinder/cacheCommand.hpp>
 
 #include <peptide.hpp>
 
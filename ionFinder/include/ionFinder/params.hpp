@@ -37,6 +37,8 @@
 #include <ionFinder/ionFinder.hpp>
 #include <paramsBase.hpp>
 #include <utils.hpp>
+#include <scanSource.hpp>
+#include <peptide.hpp>
 
 namespace IonFinder{
 	
@@ -58,6 +60,11 @@ namespace IonFinder{
 	double const DEFAULT_NEUTRAL_LOSS_MASS = CIT_NL_MASS;
 	double const CIT_MOD_MASS = 0.984289;
 
+	//!Default number of MS files read ahead of the threads searching for fragment ions
+	size_t const DEFAULT_PREFETCH_DEPTH = 2;
+	//!Default number of threads used to read MS files in the background
+	unsigned int const DEFAULT_IO_THREADS = 1;
+
 	class Params;
 	
 	class Params : public base::ParamsBase{
@@ -120,6 +127,42 @@ namespace IonFinder{
 
 		//!Should unique peptide be printed?
 		bool _printPeptideUID;
+
+		//! Should all scans from an MS file be searched by the same thread?
+		bool _fileAffinity;
+
+		//! Number of MS files to read ahead of the threads searching for fragment ions.
+		size_t _prefetchDepth;
+
+		//! Number of threads used to read MS files in the background.
+		unsigned int _numIoThread;
+
+		//! Should PSMs be streamed from input to output instead of processing each phase for all PSMs at once?
+		bool _stream;
+
+		//! Should MS files be read through a persistent scan index?
+		bool _scanIndex;
+
+		//! Should .ms2 files be memory mapped?
+		bool _mmap;
+
+		//! Maximum memory in MB used by loaded MS files. 0 for no limit.
+		size_t _maxMemory;
+
+		//! Should binary caches written by the cache subcommand be used?
+		bool _binaryCache;
+
+		//! Number of most intense peaks kept in each scan when it is read. 0 to keep all peaks.
+		size_t _topPeaks;
+
+		//! Number of most intense peaks kept in each m/z window when a scan is read. 0 to keep all peaks.
+		size_t _windowPeaks;
+
+		//! Width of m/z windows used by _windowPeaks.
+		double _peakWindow;
+
+		//! Maximum number of peptides with cached fragment ladders. 0 to disable the cache.
+		size_t _ladderCacheSize;
 		
 		bool getFlist(bool force);
 		static unsigned int computeThreads() ;
@@ -148,6 +191,18 @@ namespace IonFinder{
 			_groupMod = 1;
 			_printIonIntensity = false;
 			_printPeptideUID = false;
+			_fileAffinity = false;
+			_prefetchDepth = DEFAULT_PREFETCH_DEPTH;
+			_numIoThread = DEFAULT_IO_THREADS;
+			_stream = false;
+			_scanIndex = false;
+			_mmap = false;
+			_maxMemory = 0;
+			_binaryCache = true;
+			_topPeaks = 0;
+			_windowPeaks = 0;
+			_peakWindow = ms2::DEFAULT_PEAK_WINDOW;
+			_ladderCacheSize = PeptideNamespace::DEFAULT_LADDER_CACHE_SIZE;
 		}
 		
 		//modifiers
@@ -223,6 +278,56 @@ namespace IonFinder{
 		bool getPrintPeptideUID() const {
             return _printPeptideUID;
         }
+		bool getFileAffinity() const {
+			return _fileAffinity;
+		}
+		size_t getPrefetchDepth() const {
+			return _prefetchDepth;
+		}
+		unsigned int getNumIoThreads() const {
+			return _numIoThread;
+		}
+		bool getStream() const {
+			return _stream;
+		}
+		bool getScanIndex() const {
+			return _scanIndex;
+		}
+		bool getMmap() const {
+			return _mmap;
+		}
+		size_t getMaxMemory() const {
+			return _maxMemory;
+		}
+		bool getBinaryCache() const {
+			return _binaryCache;
+		}
+		size_t getTopPeaks() const {
+			return _topPeaks;
+		}
+		size_t getWindowPeaks() const {
+			return _windowPeaks;
+		}
+		double getPeakWindow() const {
+			return _peakWindow;
+		}
+		size_t getLadderCacheSize() const {
+			return _ladderCacheSize;
+		}
+		ms2::ReaderOptions getReaderOptions() const {
+			ms2::ReaderOptions options;
+			options.scanIndex = _scanIndex;
+			options.mmap = _mmap;
+			options.maxMemory = _maxMemory * 1024 * 1024;
+			options.binaryCache = _binaryCache;
+			options.decodeThreads = _numThread;
+			if(getMinIntensitySpecified())
+				options.peakFilter.minIntensity = getMinIntensity();
+			options.peakFilter.windowTopK = _windowPeaks;
+			options.peakFilter.windowWidth = _peakWindow;
+			options.peakFilter.topN = _topPeaks;
+			return options;
+		}
 	};
 }
 
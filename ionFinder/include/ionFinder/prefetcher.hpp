@@ -0,0 +1,100 @@
+//
+// prefetcher.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef prefetcher_hpp
+#define prefetcher_hpp
+
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+
+#include <msInterface.hpp>
+
+namespace IonFinder{
+
+    class Prefetcher;
+
+    /**
+     * Reads MS files into an ms2::MsInterface on background I/O threads so that
+     * file parsing overlaps with fragment searching. <br><br>
+     *
+     * Files are read in the order they are expected to be needed. At most \p depth files
+     * are read ahead of the worker threads. Workers call reached() when they start using a file,
+     * which frees a slot for the next file. Files reached by a worker before they were prefetched are skipped. <br>
+     * The I/O threads are not taken from the shared ThreadPool because every pool worker is searching
+     * for the whole time files are being prefetched.
+     */
+    class Prefetcher{
+    private:
+        ms2::MsInterface& _msInterface;
+
+        //!Files in the order they will be read
+        std::vector<std::string> _files;
+        //!Index of each file in _files
+        std::map<std::string, size_t> _fileIndex;
+        //!Has each file in _files been reached by a worker?
+        std::vector<bool> _reached;
+
+        //!Maximum number of files read ahead of workers
+        size_t _depth;
+        //!Index of next file to read
+        size_t _next;
+        //!Number of files claimed by an I/O thread which have not been reached by a worker
+        size_t _ahead;
+        bool _stop;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<std::thread> _threads;
+
+        //!Number of files read by I/O threads
+        std::atomic<size_t> _nRead;
+
+        void ioWorker();
+
+    public:
+        Prefetcher(ms2::MsInterface& msInterface, const std::vector<std::string>& files, size_t depth);
+        Prefetcher(const Prefetcher&) = delete;
+        Prefetcher& operator = (const Prefetcher&) = delete;
+        ~Prefetcher();
+
+        void start(unsigned int nThread);
+        void reached(const std::string& file);
+        void stop();
+
+        size_t getNumRead() const{
+            return _nRead.load();
+        }
+    };
+}
+
+#endif /* prefetcher_hpp */
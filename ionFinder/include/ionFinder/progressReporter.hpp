@@ -0,0 +1,131 @@
+//
+// progressReporter.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef progressReporter_hpp
+#define progressReporter_hpp
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+
+#include <utils.hpp>
+
+namespace IonFinder{
+
+    class ProgressCounter;
+    class ProgressReporter;
+
+    //!Size of padding used to keep counters for different threads on separate cache lines
+    size_t const CACHE_LINE_SIZE = 64;
+    //!Progress bar sleep time in seconds
+    int const PROGRESS_SLEEP_TIME = 1;
+    //!Max iterations of progress bar loop with no progress before a warning is printed
+    int const MAX_PROGRESS_ITTERATIONS = 600;
+    //!Progress bar width in chars
+    int const PROGRESS_BAR_WIDTH = 40;
+
+    /**
+     * Number of items completed by a single thread. <br>
+     * Padded on both sides because std::vector storage is not cache line aligned in C++11.
+     * Counters next to each other in a vector then never share a cache line.
+     */
+    class ProgressCounter{
+    private:
+        char _pre[CACHE_LINE_SIZE];
+        std::atomic<size_t> _count;
+        char _post[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    public:
+        ProgressCounter() : _count(0) {}
+        ProgressCounter(const ProgressCounter&) = delete;
+        ProgressCounter& operator = (const ProgressCounter&) = delete;
+
+        void add(size_t n = 1){
+            _count.fetch_add(n, std::memory_order_relaxed);
+        }
+        ProgressCounter& operator ++ (){
+            add(1);
+            return *this;
+        }
+        size_t get() const{
+            return _count.load(std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * Prints progress of a phase processed by one or more threads. <br><br>
+     *
+     * Each thread updates its own ProgressCounter so threads never write to the same cache line.
+     * A reporter thread sums the counters every PROGRESS_SLEEP_TIME seconds and prints a progress bar
+     * with throughput, estimated time remaining and the range of items completed by each thread.
+     * The reporter waits on a condition variable, so finish() wakes it immediately instead of
+     * waiting for the next update.
+     */
+    class ProgressReporter{
+    private:
+        std::string _message;
+        //!Total number of items. If 0, the total is unknown and only the count and rate are shown.
+        size_t _total;
+        //!Should the progress bar be shown?
+        bool _show;
+        std::vector<ProgressCounter> _counters;
+
+        std::thread _thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool _done;
+        bool _started;
+        std::chrono::steady_clock::time_point _startTime;
+
+        void run();
+        void print(std::ostream& out) const;
+        double elapsed() const;
+
+    public:
+        ProgressReporter(std::string message, size_t total, unsigned int nThread = 1, bool show = true);
+        ProgressReporter(const ProgressReporter&) = delete;
+        ProgressReporter& operator = (const ProgressReporter&) = delete;
+        ~ProgressReporter();
+
+        void start();
+        void finish();
+
+        ProgressCounter& getCounter(unsigned int thread){
+            return _counters[thread];
+        }
+        size_t count() const;
+    };
+}
+
+#endif /* progressReporter_hpp */
@@ -0,0 +1,136 @@
+//
+// scanScheduler.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef scanScheduler_hpp
+#define scanScheduler_hpp
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <map>
+#include <cstddef>
+
+namespace IonFinder{
+
+    class ScanScheduler;
+
+    //!Minimum number of scans in a single batch
+    size_t const MIN_SCAN_BATCH_SIZE = 1;
+    //!Maximum number of scans in a single batch
+    size_t const MAX_SCAN_BATCH_SIZE = 64;
+    //!Target number of batches initially assigned to each worker
+    size_t const BATCHES_PER_WORKER = 16;
+
+    //!A set of indices in the input scan list which are processed together by one worker.
+    struct ScanBatch{
+        //!Indices of scans in batch, in ascending order.
+        std::vector<size_t> indices;
+        //!If not empty, all scans in the batch are from this MS file.
+        std::string file;
+
+        //!Construct batch for the contiguous range [\p beg, \p end)
+        ScanBatch(size_t beg, size_t end){
+            for(size_t i = beg; i < end; i++)
+                indices.push_back(i);
+        }
+        ScanBatch(std::string _file, std::vector<size_t> _indices){
+            file = std::move(_file);
+            indices = std::move(_indices);
+        }
+        size_t size() const{
+            return indices.size();
+        }
+    };
+
+    //!Per worker statistics collected by ScanScheduler.
+    struct WorkerStats{
+        //!Seconds spent processing scans
+        double busyTime;
+        //!Number of scans processed
+        size_t nScans;
+        //!Number of batches processed
+        size_t nBatches;
+        //!Number of batches taken from another worker's queue
+        size_t nStolen;
+        WorkerStats(){
+            busyTime = 0;
+            nScans = 0;
+            nBatches = 0;
+            nStolen = 0;
+        }
+    };
+
+    /**
+     * Work stealing scheduler for distributing batches of scans across worker threads. <br><br>
+     *
+     * The scan list is split into small batches which are dealt out in contiguous blocks to a
+     * deque owned by each worker. Workers take batches from the front of their own deque so that
+     * scans are processed in input order. When a worker's deque is empty it steals from the back of
+     * the deque of the worker with the most remaining batches. <br><br>
+     *
+     * In file affinity mode, each batch contains every scan from a single MS file so
+     * that each file is only read by the one worker which owns the batch.
+     */
+    class ScanScheduler{
+    private:
+        struct WorkerQueue{
+            std::mutex mutex;
+            std::deque<size_t> batches;
+        };
+
+        std::vector<ScanBatch> _batches;
+        std::vector<std::unique_ptr<WorkerQueue> > _queues;
+
+        void initQueues(unsigned int nWorkers);
+        bool popOwn(unsigned int worker, size_t& batchIndex);
+        bool steal(unsigned int worker, size_t& batchIndex);
+
+    public:
+        ScanScheduler(size_t nScans, unsigned int nWorkers, size_t batchSize = 0);
+        ScanScheduler(const std::vector<std::string>& scanFiles, unsigned int nWorkers);
+
+        static size_t calcBatchSize(size_t nScans, unsigned int nWorkers);
+
+        bool next(unsigned int worker, size_t& batchIndex, bool& stolen);
+        std::vector<size_t> projectedOrder() const;
+
+        const ScanBatch& getBatch(size_t i) const{
+            return _batches[i];
+        }
+        size_t getNumBatches() const{
+            return _batches.size();
+        }
+        unsigned int getNumWorkers() const{
+            return (unsigned int)_queues.size();
+        }
+    };
+}
+
+#endif /* scanScheduler_hpp */
@@ -0,0 +1,140 @@
+//
+// stream.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef stream_hpp
+#define stream_hpp
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+
+#include <ionFinder/params.hpp>
+#include <ionFinder/inputFiles.hpp>
+#include <ionFinder/datProc.hpp>
+#include <ionFinder/boundedQueue.hpp>
+#include <ionFinder/progressReporter.hpp>
+#include <ionFinder/threadPool.hpp>
+#include <dtafilter.hpp>
+#include <peptide.hpp>
+#include <msInterface.hpp>
+#include <ms2Spectrum.hpp>
+#include <fastaFile.hpp>
+
+namespace IonFinder{
+
+    class StreamPipeline;
+
+    //!Capacity of each queue between streaming pipeline stages
+    size_t const STREAM_QUEUE_SIZE = 256;
+    //!Maximum number of PSMs which have been read but not written, for each labeling thread
+    size_t const STREAM_WINDOW_PER_THREAD = 512;
+
+    //!A single PSM moving through the streaming pipeline.
+    struct StreamItem{
+        //!Position of PSM in input
+        size_t index;
+        Dtafilter::Scan scan;
+        //!Labeled peptide. Cleared once the peptide has been analyzed.
+        PeptideNamespace::Peptide peptide;
+        //!Results of analysis. Each PeptideStats points to \p scan.
+        std::vector<PeptideStats> stats;
+    };
+
+    /**
+     * Process PSMs from the input files to the peptide stats output without holding all of them in memory. <br><br>
+     *
+     * Stages are connected by bounded queues:
+     * <ol>
+     *   <li>One thread parses the input files.</li>
+     *   <li>Each worker in the shared ThreadPool gets and labels the spectrum for each PSM.</li>
+     *   <li>One thread analyzes each labeled peptide, then frees its fragments.</li>
+     *   <li>One thread writes rows in input order.</li>
+     * </ol>
+     * The number of PSMs between being read and written is limited, so memory use does not
+     * grow with the size of the input. Output is identical to the non streaming path. <br>
+     * The read, analyze and write stages each block on a queue for the whole run, so they have
+     * their own threads instead of holding pool workers the labeling stage needs.
+     */
+    class StreamPipeline{
+    private:
+        typedef std::unique_ptr<StreamItem> ItemPtr;
+
+        const IonFinder::Params& _pars;
+        ThreadPool& _pool;
+        unsigned int _nThread;
+        //!Maximum number of PSMs read but not written
+        size_t _window;
+
+        BoundedQueue<ItemPtr> _labelQueue;
+        BoundedQueue<ItemPtr> _analyzeQueue;
+        BoundedQueue<ItemPtr> _writeQueue;
+
+        ms2::MsInterface _msInterface;
+        PeptideNamespace::LadderCache _ladderCache;
+        //!Amino acid masses for each sample, read the first time a sample reaches a labeling thread
+        AADBCache _aadbCache;
+        utils::FastaFile _seqFile;
+        bool _addModResidues;
+        int _nSeqNotFound;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t _nRead;
+        size_t _nWritten;
+        bool _failed;
+        std::string _error;
+        std::atomic<unsigned int> _labelThreadsRunning;
+        //!Incremented for each PSM written
+        ProgressCounter* _progress;
+
+        void readStage();
+        void labelStage();
+        void analyzeStage();
+        void writeStage(std::ostream& out);
+        void fail(const std::string& message);
+
+    public:
+        StreamPipeline(const IonFinder::Params& pars, ThreadPool& pool);
+        StreamPipeline(const StreamPipeline&) = delete;
+        StreamPipeline& operator = (const StreamPipeline&) = delete;
+
+        bool run();
+
+        size_t getNumWritten() const{
+            return _nWritten;
+        }
+    };
+}
+
+#endif /* stream_hpp */
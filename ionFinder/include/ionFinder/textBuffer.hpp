@@ -0,0 +1,132 @@
+//
+// textBuffer.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef textBuffer_hpp
+#define textBuffer_hpp
+
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstddef>
+
+namespace IonFinder{
+
+    class TextBuffer;
+
+    /**
+     * Append only text buffer with fast number formatting. <br><br>
+     *
+     * Values are formatted exactly as a std::ostream with default flags would format them,
+     * so a TextBuffer can be used in place of a std::ostream to build output which is then
+     * written in one large block. Integers are converted without going through a locale
+     * and doubles are formatted with std::snprintf using the same %g conversion as std::ostream.
+     */
+    class TextBuffer{
+    private:
+        std::string _buffer;
+
+        void appendUnsigned(unsigned long long value);
+        void appendSigned(long long value);
+        void appendDouble(double value);
+
+    public:
+        TextBuffer() = default;
+
+        TextBuffer& operator << (const std::string& value){
+            _buffer.append(value);
+            return *this;
+        }
+        TextBuffer& operator << (const char* value){
+            _buffer.append(value);
+            return *this;
+        }
+        TextBuffer& operator << (char value){
+            _buffer.push_back(value);
+            return *this;
+        }
+        TextBuffer& operator << (bool value){
+            _buffer.push_back(value ? '1' : '0');
+            return *this;
+        }
+        TextBuffer& operator << (int value){
+            appendSigned(value);
+            return *this;
+        }
+        TextBuffer& operator << (long value){
+            appendSigned(value);
+            return *this;
+        }
+        TextBuffer& operator << (long long value){
+            appendSigned(value);
+            return *this;
+        }
+        TextBuffer& operator << (unsigned int value){
+            appendUnsigned(value);
+            return *this;
+        }
+        TextBuffer& operator << (unsigned long value){
+            appendUnsigned(value);
+            return *this;
+        }
+        TextBuffer& operator << (unsigned long long value){
+            appendUnsigned(value);
+            return *this;
+        }
+        TextBuffer& operator << (double value){
+            appendDouble(value);
+            return *this;
+        }
+        TextBuffer& operator << (float value){
+            appendDouble(value);
+            return *this;
+        }
+
+        const std::string& str() const{
+            return _buffer;
+        }
+        size_t size() const{
+            return _buffer.size();
+        }
+        bool empty() const{
+            return _buffer.empty();
+        }
+        void reserve(size_t n){
+            _buffer.reserve(n);
+        }
+        void clear(){
+            _buffer.clear();
+        }
+        //! Clear buffer and free its memory.
+        void release(){
+            std::string().swap(_buffer);
+        }
+
+        bool write(std::ostream& out) const;
+    };
+}
+
+#endif /* textBuffer_hpp */
@@ -0,0 +1,121 @@
+//
+// threadPool.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef threadPool_hpp
+#define threadPool_hpp
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+
+namespace IonFinder{
+
+    class ThreadPool;
+
+    //!Target number of chunks for each thread in ThreadPool::parallelFor when no chunk size is given
+    size_t const CHUNKS_PER_THREAD = 4;
+
+    /**
+     * Fixed size pool of worker threads shared by all parallel phases of the program. <br><br>
+     *
+     * Tasks are added with submit() and run in the order they were submitted.
+     * parallelFor() splits a range into chunks which are processed by the pool workers
+     * and the calling thread. If parallelFor() is called from one of the pool's own workers,
+     * the range is processed inline so nested parallel sections can not deadlock the pool.
+     */
+    class ThreadPool{
+    private:
+        std::vector<std::thread> _workers;
+        std::deque<std::function<void()> > _tasks;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool _stop;
+
+        //!Pool the current thread belongs to, or nullptr if the thread is not a pool worker.
+        static thread_local const ThreadPool* _currentPool;
+        //!Index of the current thread in _currentPool.
+        static thread_local unsigned int _currentIndex;
+
+        void workerLoop(unsigned int index);
+
+    public:
+        explicit ThreadPool(unsigned int nThread);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator = (const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        /**
+         * Add a task to the pool.
+         * Waiting on the returned future from inside a pool worker can deadlock if all workers are busy.
+         * \param f Callable with no arguments.
+         * \return Future for the result of \p f. Exceptions thrown by \p f are rethrown by std::future::get.
+         */
+        template<typename F>
+        std::future<typename std::result_of<F()>::type> submit(F f){
+            typedef typename std::result_of<F()>::type R;
+            auto task = std::make_shared<std::packaged_task<R()> >(std::move(f));
+            std::future<R> ret = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                _tasks.emplace_back([task](){ (*task)(); });
+            }
+            cv.notify_one();
+            return ret;
+        }
+
+        void parallelFor(size_t begin, size_t end, size_t chunkSize,
+                         const std::function<void(size_t, size_t)>& fn);
+
+        //! Number of worker threads.
+        unsigned int size() const{
+            return (unsigned int)_workers.size();
+        }
+        //! Is the calling thread one of this pool's workers?
+        bool inWorker() const{
+            return _currentPool == this;
+        }
+        /**
+         * Index of the calling thread.
+         * \return Index of worker in [0, size()) or size() if the calling thread is not a worker.
+         */
+        unsigned int workerIndex() const{
+            return inWorker() ? _currentIndex : size();
+        }
+    };
+}
+
+#endif /* threadPool_hpp */
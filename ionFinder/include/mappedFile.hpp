@@ -0,0 +1,94 @@
+//
+// mappedFile.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_mappedFile_hpp
+#define ionfinder_mappedFile_hpp
+
+#include <string>
+#include <cstddef>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <vector>
+#endif
+
+namespace ms2 {
+
+    /**
+     * Read only memory mapping of an entire file.
+     * Pages are only loaded from disk when they are accessed, so the resident memory
+     * used by the mapping tracks the parts of the file which are actually read.
+     * On platforms without mmap the file is read into memory instead.
+     */
+    class MappedFile {
+    public:
+        //! Expected access pattern. Passed to the kernel as a hint.
+        enum class Advice {SEQUENTIAL, RANDOM, DONT_NEED};
+
+    private:
+        const char* _data;
+        size_t _size;
+#ifdef _WIN32
+        std::vector<char> _buffer;
+#endif
+
+    public:
+        MappedFile() : _data(nullptr), _size(0) {}
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator = (const MappedFile&) = delete;
+        ~MappedFile() {
+            close();
+        }
+
+        bool open(const std::string& fname);
+        void close();
+        void advise(Advice advice) const;
+
+        bool isOpen() const {
+            return _data != nullptr;
+        }
+        const char* data() const {
+            return _data;
+        }
+        size_t size() const {
+            return _size;
+        }
+        const char* begin() const {
+            return _data;
+        }
+        const char* end() const {
+            return _data + _size;
+        }
+    };
+}
+
+#endif //ionfinder_mappedFile_hpp
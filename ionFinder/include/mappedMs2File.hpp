@@ -0,0 +1,79 @@
+//
+// mappedMs2File.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_mappedMs2File_hpp
+#define ionfinder_mappedMs2File_hpp
+
+#include <string>
+#include <vector>
+
+#include <scanSource.hpp>
+#include <scanIndex.hpp>
+#include <mappedFile.hpp>
+#include <indexedMsFile.hpp>
+
+namespace ms2 {
+
+    /**
+     * ScanSource for .ms2 files which memory maps the file.
+     * Scan header offsets are recorded in one pass when the file is read,
+     * but peak lines are only parsed when getScan asks for a scan.
+     * Only the pages holding requested scans stay resident.
+     */
+    class MappedMs2File : public ScanSource {
+        typedef utils::msInterface::ScanIon ScanIon;
+        typedef utils::msInterface::PrecursorScan PrecursorScan;
+
+        std::string _fname;
+        MappedFile _file;
+        ScanIndex _index;
+        //! Read and write the index sidecar instead of scanning the file on every run.
+        bool _useSidecar;
+
+    public:
+        explicit MappedMs2File(bool useSidecar = false) : _fname(""), _useSidecar(useSidecar) {}
+
+        bool read(const std::string& fname) override;
+        bool getScan(size_t scanNum, ms2::Spectrum& scan) const override;
+
+        /**
+         * Pages of the mapping are clean file pages which the kernel can drop at any time,
+         * so only the index is counted.
+         */
+        size_t estimateMemory(const std::string&) const override {
+            return 0;
+        }
+        size_t memoryUsage() const override {
+            return _index.memoryUsage();
+        }
+        const ScanIndex& getIndex() const {
+            return _index;
+        }
+    };
+}
+
+#endif //ionfinder_mappedMs2File_hpp
@@ -48,6 +48,7 @@
 #include <calcLableLocs.hpp>
 #include <scanData.hpp>
 #include <spectrum_constants.hpp>
+#include <peakFilter.hpp>
 
 namespace ms2{
 	
@@ -78,6 +79,8 @@ namespace ms2{
 		bool topAbundant;
 		PeptideNamespace::IonType ionType;
 		int ionNum;
+		//! Index of peptide fragment labeling the ion whose label strings have not been made yet.
+		size_t _fragment;
 		//! Is the ion statistically considered noise?
         bool _noise;
         //! Signal to noise ratio
@@ -91,6 +94,7 @@ namespace ms2{
 			formatedLabel = NA_STR;
 			ionType = PeptideNamespace::IonType::BLANK;
 			ionNum = 0;
+			_fragment = std::string::npos;
 			_noise = true;
 			_snr = 0;
 		}
@@ -242,6 +246,9 @@ namespace ms2{
         void removeIntensityBelow(double minInt);
         void removeSNRBelow(double snrThreshold, double snrConf = 0.9);
         void setMZRange(double minMZ, double maxMZ, bool _sort = true);
+		void assign(size_t scanNum, const utils::msInterface::PrecursorScan& precursor,
+		            std::vector<utils::msInterface::ScanIon>& ions);
+		void filterIons(const PeakFilter& filter);
 
 		/**
 		 * Normalize ion intensities so that the max intensity is \p max.
@@ -260,6 +267,7 @@ namespace ms2{
 						   const base::ParamsBase& pars,
 						   bool removeUnlabeledFrags = false,
 						   size_t labelTop = LABEL_TOP);
+		void makeLabels(const PeptideNamespace::Peptide& peptide);
 		void calcLabelPos(double maxPerc,
 						  double offset_x, double offset_y,
 						  double padding_x, double padding_y);
@@ -31,38 +31,119 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <algorithm>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
 
 #include <dtafilter.hpp>
-#include <msInterface/msInterface.hpp>
 #include <msInterface/msScan.hpp>
-#include <msInterface/ms2File.hpp>
-#include <msInterface/mzXMLFile.hpp>
-#include <msInterface/mzMLFile.hpp>
+#include <ms2Spectrum.hpp>
+#include <scanSource.hpp>
+#include <gzipStream.hpp>
 
 namespace ms2 {
     class MsInterface;
 
+    /**
+     * Concurrent registry of MS files.
+     * Each file is parsed exactly once no matter how many threads request it at the same time.
+     * The first thread to request a file parses it while the others wait on the same file entry.
+     * Lookups of files which are already registered are lock free. The file map is copy on write,
+     * writers publish a new snapshot under \p writeMutex and readers only load the current snapshot pointer. <br><br>
+     *
+     * Files are released as soon as every PSM registered with addNeededScans has been released with release.
+     * If ReaderOptions::maxMemory is set, threads loading a file block until there is room for it,
+     * evicting the least recently used files which are not being read from.
+     */
     class MsInterface {
-        typedef std::map<std::string, std::shared_ptr<utils::msInterface::MsInterface> > Ms2Map;
+        typedef ms2::ScanSource MsFile;
         typedef std::vector<Dtafilter::Scan> InputScanList;
 
-        std::mutex mutex;
-        Ms2Map _ms2Map;
+        //! Registry entry for a single file.
+        struct FileEntry {
+            //! Ensures the file is only parsed once.
+            std::once_flag loaded;
+            //! Was the file successfully read? Only valid after \p loaded has been called.
+            bool success;
+            //! Set when the entry is removed from the registry.
+            std::atomic<bool> removed;
+            //! Parsed file. Accessed with std::atomic_load and std::atomic_store.
+            std::shared_ptr<MsFile> file;
+            //! Bytes charged to the memory budget for this file.
+            std::atomic<size_t> memory;
+            //! Value of MsInterface::_useClock the last time the file was used.
+            std::atomic<uint64_t> lastUsed;
+            FileEntry() : success(false), removed(false), file(nullptr), memory(0), lastUsed(0) {}
+        };
+        typedef std::map<std::string, std::shared_ptr<FileEntry> > FileMap;
+
+        //! Current snapshot of the file map.
+        std::atomic<const FileMap*> _files;
+        //! Number of threads currently reading a snapshot.
+        mutable std::atomic<size_t> _readers;
+        //! How files are read.
+        const ReaderOptions _options;
+        //! Serializes writers. Also guards \p _retired.
+        std::mutex writeMutex;
+        //! Snapshots which have been replaced but may still be in use by a reader.
+        std::vector<const FileMap*> _retired;
+
+        //! Sorted scan numbers which will be requested from each file.
+        std::map<std::string, std::vector<size_t> > _neededScans;
+        //! Number of PSMs from each file which have not been released.
+        std::map<std::string, size_t> _remaining;
+        //! Guards \p _neededScans and \p _remaining.
+        mutable std::mutex neededScansMutex;
+        std::vector<size_t> getNeededScans(const std::string& fname) const;
+        bool finished(const std::string& fname) const;
+
+        //! Bytes charged to the memory budget by loaded and loading files.
+        size_t _memoryUsed;
+        //! Guards \p _memoryUsed.
+        std::mutex memoryMutex;
+        std::condition_variable memoryCv;
+        //! Incremented each time a file is used.
+        mutable std::atomic<uint64_t> _useClock;
+
+        void reserveMemory(const std::string& fname, size_t bytes);
+        bool tryReserveMemory(size_t bytes);
+        void releaseMemory(size_t bytes);
+        bool evictIdle(const std::string& exclude);
+
+        std::shared_ptr<FileEntry> findEntry(const std::string& fname) const;
+        std::shared_ptr<FileEntry> insertEntry(const std::string& fname);
+        void publish(const FileMap* files);
+        std::shared_ptr<MsFile> getFile(const std::string& fname, size_t reserved = 0);
+        bool loadFile(const std::string& fname, FileEntry& entry, size_t reserved);
+        bool readFile(const std::string& fname, size_t reserved);
+
         void getUniqueFileList(std::vector<std::string>& fnames,
                                std::vector<Dtafilter::Scan>::const_iterator begin,
                                std::vector<Dtafilter::Scan>::const_iterator end) const;
     public:
-        MsInterface(){
-            _ms2Map = Ms2Map();
+        explicit MsInterface(const ReaderOptions& options = ReaderOptions())
+            : _files(new FileMap()), _readers(0), _options(options), _memoryUsed(0), _useClock(0) {
+            // decode threads are shared by every file being loaded at once
+            DecodeThreads::setLimit(options.decodeThreads);
         }
-        ~MsInterface(){}
+        MsInterface(const MsInterface&) = delete;
+        MsInterface& operator = (const MsInterface&) = delete;
+        ~MsInterface();
 
+        void addNeededScans(InputScanList::const_iterator begin, InputScanList::const_iterator end);
+        void addNeededScan(const Dtafilter::Scan& scan);
         bool read(InputScanList::const_iterator begin, InputScanList::const_iterator end);
         bool read(std::string fname);
-        bool getScan(utils::msInterface::Scan&, std::string fname, size_t scanNum) const;
-        bool getScan(utils::msInterface::Scan&, std::string fname, size_t scanNum);
+        bool prefetch(const std::string& fname);
+        void remove(const std::string& fname);
+        void release(const std::string& fname, size_t nScans = 1);
+        size_t getMemoryUsed();
+        bool getScan(ms2::Spectrum&, std::string fname, size_t scanNum) const;
+        bool getScan(ms2::Spectrum&, std::string fname, size_t scanNum);
     };
 
 }
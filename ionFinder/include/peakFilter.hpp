@@ -0,0 +1,69 @@
+//
+// peakFilter.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_peakFilter_hpp
+#define ionfinder_peakFilter_hpp
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstddef>
+
+#include <msInterface/msScan.hpp>
+
+namespace ms2 {
+
+    //! Default width of the m/z windows used by PeakFilter::windowTopK.
+    double const DEFAULT_PEAK_WINDOW = 100;
+
+    /**
+     * Peak reduction applied by ScanSource readers before a scan is stored or copied into a Spectrum.
+     * Filters are applied in the order they are declared. Every filter keeps the most intense peak,
+     * so intensities normalized after filtering are the same as without filtering.
+     */
+    struct PeakFilter {
+        //! Remove peaks below this percentage of the most intense peak. 0 to keep all peaks.
+        double minIntensity;
+        //! Keep only the \p windowTopK most intense peaks in each m/z window. 0 to keep all peaks.
+        size_t windowTopK;
+        //! Width of m/z windows in Th. Windows begin at multiples of the width.
+        double windowWidth;
+        //! Keep only the \p topN most intense peaks. 0 to keep all peaks.
+        size_t topN;
+
+        PeakFilter() : minIntensity(0), windowTopK(0), windowWidth(DEFAULT_PEAK_WINDOW), topN(0) {}
+
+        //! Does the filter remove any peaks?
+        bool active() const {
+            return minIntensity > 0 || windowTopK > 0 || topN > 0;
+        }
+        void apply(std::vector<utils::msInterface::ScanIon>& ions) const;
+    };
+}
+
+#endif //ionfinder_peakFilter_hpp
@@ -36,6 +36,10 @@
 #include <string>
 #include <iomanip>
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <utils.hpp>
 #include <aaDB.hpp>
@@ -50,8 +54,9 @@ namespace PeptideNamespace{
     class AminoAcid;
     class Peptide;
     class FragmentIon;
+    class LadderCache;
 
-    const double H_MASS = 1.00732;
+    double constexpr H_MASS = 1.00732;
     //const double H_MASS = 1.00783;
 
     //!Enumerated fragment ion classifications
@@ -65,14 +70,80 @@ namespace PeptideNamespace{
 
     //forward function declarations
     //peptide mass functions
-    double calcMass(double mz, int charge);
-    double calcMZ(double mass, int charge);
+    //! Neutral mass of ion with \p mz and \p charge.
+    inline constexpr double calcMass(double mz, int charge){
+        return mz * charge - (charge * H_MASS);
+    }
+    //! m/z of ion with neutral \p mass and \p charge.
+    inline constexpr double calcMZ(double mass, int charge){
+        return (mass + (charge * H_MASS)) / charge;
+    }
     double calcMass(std::string sequence);
     double calcMass(PepIonIt begin, PepIonIt end);
 
     //Modification helper functions
     std::string concatMods(PepIonIt begin, PepIonIt end);
 
+    /**
+     * Fragment ion identity packed into a single integer. <br>
+     * Holds the ion type, number, charge, number of modifications and neutral loss multiple.
+     * Within one Peptide, fragments with the same key have the same label, so keys can be
+     * compared and stored in sets in place of label strings until the label is printed.
+     */
+    class IonKey{
+    private:
+        std::uint64_t _key;
+    public:
+        IonKey(){
+            _key = 0;
+        }
+        IonKey(IonType ionType, int num, int charge, size_t nMod, size_t numNl){
+            _key = (std::uint64_t((std::uint8_t)ionType) << 56) |
+                   (std::uint64_t((std::uint8_t)charge) << 48) |
+                   (std::uint64_t((std::uint16_t)num) << 32) |
+                   (std::uint64_t((std::uint16_t)nMod) << 16) |
+                   std::uint64_t((std::uint16_t)numNl);
+        }
+
+        IonType getIonType() const{
+            return IonType(_key >> 56);
+        }
+        int getCharge() const{
+            return (std::int8_t)(_key >> 48);
+        }
+        int getNum() const{
+            return (std::uint16_t)(_key >> 32);
+        }
+        size_t getNumMod() const{
+            return (std::uint16_t)(_key >> 16);
+        }
+        size_t getNumNl() const{
+            return (std::uint16_t)_key;
+        }
+        bool isNL() const{
+            return getIonType() == IonType::B_NL ||
+                   getIonType() == IonType::Y_NL ||
+                   getIonType() == IonType::M_NL;
+        }
+        bool isM() const{
+            return getIonType() == IonType::M || getIonType() == IonType::M_NL;
+        }
+
+        bool operator < (const IonKey& rhs) const{
+            return _key < rhs._key;
+        }
+        bool operator == (const IonKey& rhs) const{
+            return _key == rhs._key;
+        }
+    };
+
+    //Ion label functions
+    char ionTypeToBY(const IonType&);
+    std::string makeNLStr(size_t numNl, double nlMass);
+    std::string makeIonLabel(const IonKey& key, const std::string& mod, double nlMass,
+                             const std::string& chargeSep = " ");
+    std::string makeFormatedIonLabel(const IonKey& key, const std::string& mod, double nlMass);
+
     //mass calculation functions
     void initAminoAcidsMasses(const base::ParamsBase& pars, std::string seqParFname, aaDB::AADB&);
     void initAminoAcidsMasses(const base::ParamsBase&, aaDB::AADB&);
@@ -129,6 +200,7 @@ namespace PeptideNamespace{
             return charge;
         }
         std::string makeChargeLable() const;
+        static std::string makeChargeLable(int charge);
     };//end of class
 
     class AminoAcid : public Ion{
@@ -177,160 +249,67 @@ namespace PeptideNamespace{
 
     };
 
-    //!Used to represent b and y peptide ions
-    class FragmentIon : public Ion{
-    protected:
-        char _b_y;
-        int _num;
-        //!Represents all symbol for modification
-        /** i.e. if two modifications are present, mod will be "**" */
-        std::string _mod;
-        //!Was peptide fragment found in ms2 spectra?
-        bool _found;
-        IonType _ionType;
-        //!Represents neutral loss mass
-        double _nlMass;
-        //!Represents multiples of base neutral loss mass on peptide
-        size_t _numNl;
-        //!Should ion label be included in spectrum?
-        bool _includeLabel;
-
-        //!sequence of fragment
-        std::string _sequence;
+    //!Default maximum number of peptides held by a LadderCache
+    size_t const DEFAULT_LADDER_CACHE_SIZE = 10000;
+
+    /**
+     * Fragment ladder of a Peptide stored as parallel arrays indexed by fragment.
+     * Sequences, modification symbols and labels are not stored. They are made on demand
+     * by FragmentIon from the Peptide the fragments were calculated from.
+     * Whether each fragment was found is stored in the Peptide, so a ladder can be shared
+     * by every Peptide with the same sequence.
+     */
+    struct FragmentArrays{
+        //!Mass used to calculate mz
+        std::vector<double> mass;
+        std::vector<double> mz;
+        std::vector<IonType> ionType;
+        //!Fragment ion number
+        std::vector<std::uint16_t> num;
+        std::vector<std::int8_t> charge;
         //!index of beginning of fragment relative to full sequence
-        size_t _beg;
+        std::vector<std::uint16_t> beg;
         //!index of end of fragment relative to full sequence
-        size_t _end;
-        //!mz of found match
-        double _foundMZ;
-        //!int of found ion in spectrum
-        double _foundIntensity;
-
-        void _initFragSpan(const std::string&);
-
+        std::vector<std::uint16_t> end;
+        //!Number of dynamic modifications on fragment
+        std::vector<std::uint16_t> nMod;
+        //!Represents multiples of base neutral loss mass on fragment
+        std::vector<std::uint16_t> numNl;
+        //!Should ion label be included in spectrum?
+        std::vector<bool> includeLabel;
+        //!Base neutral loss mass of neutral loss fragments
+        double nlMass;
 
-    public:
-        //!blank constructor
-        FragmentIon() : Ion(){
-            _b_y = '\0';
-            _num = 0;
-            _mod = "";
-            _found = false;
-            _ionType = IonType::BLANK;
-            _nlMass = 0.0;
-            _numNl = 0;
-            _sequence = "";
-            _beg = std::string::npos;
-            _end = std::string::npos;
-            _includeLabel = false;
-            _foundMZ = 0;
-            _foundIntensity = 0;
-        }
-        FragmentIon(char b_y, int num, int charge, double mass,
-                    std::string mod, const std::string& pepSequence);
-        FragmentIon(const FragmentIon& rhs);
-        ~FragmentIon() = default;
-
-        void setFound(bool boo){
-            _found = boo;
-        }
-        void setIonType(IonType it){
-            _ionType = it;
-        }
-        void setForceLabel(bool boo){
-            _includeLabel = boo;
-        }
-        void setFoundMZ(double mz){
-            _foundMZ = mz;
-        }
-        void setFoundIntensity(double intensity){
-            _foundIntensity = intensity;
+        FragmentArrays(){
+            nlMass = 0;
         }
 
-        //properties
-        double getMZ() const override{
-            if(_b_y == 'b')
-                return (mass + ((charge - 1) * PeptideNamespace::H_MASS)) / charge;
-            return Ion::getMZ(charge);
-        }
-        std::string getLabel(bool includeMod = true, std::string chargeSep = " ") const;
-        std::string getFormatedLabel() const;
-        char getBY() const{
-            return _b_y;
-        }
-        //!Get fragment ion number
-        int getNum() const{
-            return _num;
-        }
-        //!Get copy of FragmentIon::mod
-        std::string getMod() const{
-            return _mod;
-        }
-        //!Get number of modifications on fragment
-        size_t getNumMod() const{
-            return _mod.length();
-        }
-        //!Get number of neutral loss multiples on fragment
-        size_t getNumNl() const{
-            return _numNl;
-        }
-        bool getFound() const{
-            return _found;
-        }
-        IonType getIonType() const{
-            return _ionType;
-        }
-        bool getIncludeLabel() const{
-            return _includeLabel;
-        }
-        std::string ionTypeToStr() const;
-        std::string getNLStr() const;
-        bool isModified() const{
-            return !_mod.empty();
-        }
-        /**
-         * \return true if fragment is neutral loss ion
-         */
-        bool isNL() const{
-            return _ionType == IonType::B_NL ||
-                   _ionType == IonType::Y_NL ||
-                   _ionType == IonType::M_NL;
-        }
-        /**
-         * \return true if fragment is parent ion or parent neutral loss
-         */
-        bool isM() const{
-            return _ionType == IonType::M || _ionType == IonType::M_NL;
-        }
-        FragmentIon makeNLFrag(double lossMass, size_t numNL) const;
-
-        std::string getSequence() const{
-            return _sequence;
-        }
-        size_t getBegin() const{
-            return _beg;
-        }
-        size_t getEnd() const{
-            return _end;
-        }
-        double getFoundIntensity() const{
-            return _foundIntensity;
-        }
-        double getFoundMZ() const{
-            return _foundMZ;
+        size_t size() const{
+            return mz.size();
         }
+        void clear();
+        void reserve(size_t n);
+        void add(IonType ionType, int num, int charge, double mass,
+                 size_t beg, size_t end, size_t nMod, size_t numNl = 0);
+        void remove(const std::vector<bool>& remove);
     };
 
     //!Used to store fragment data for each peptide.
     class Peptide : public Ion{
+        friend class FragmentIon;
     private:
-        typedef std::vector<FragmentIon> FragmentIonType;
-
         std::string sequence;
         std::string fullSequence;
         std::vector<AminoAcid> aminoAcids;
         bool initialized;
-        FragmentIonType fragments;
+        //!Fragment ladder. Never modified after it is assigned because it may be shared with other Peptides.
+        std::shared_ptr<const FragmentArrays> fragments;
+        //!Was fragment found in ms2 spectra?
+        std::vector<bool> found;
+        //!mz of found match
+        std::vector<double> foundMZ;
+        //!int of found ion in spectrum
+        std::vector<double> foundIntensity;
         //!number of modified residues
         int nMod;
         //!Locations of dynamic modifications on peptide sequence
@@ -343,6 +322,8 @@ namespace PeptideNamespace{
         void fixDiffMod(const aaDB::AADB& aminoAcidsMasses,
                         const char* diffmods = "*");
         size_t nModsInSpan(size_t beg, size_t end) const;
+        void setFragments(std::shared_ptr<const FragmentArrays> _fragments);
+        void removeFragments(const std::vector<bool>& remove);
     public:
         //constructors
         Peptide() : Ion(){
@@ -359,11 +340,17 @@ namespace PeptideNamespace{
             initialized = false;
             nMod = 0;
         }
+        Peptide(const Peptide&) = default;
+        Peptide(Peptide&&) = default;
         ~Peptide() = default;
+        Peptide& operator = (const Peptide&) = default;
+        Peptide& operator = (Peptide&&) = default;
 
         //modifiers
         void initialize(const base::ParamsBase&, const aaDB::AADB& aadb,
                         bool _calcFragments = true);
+        void initialize(const base::ParamsBase& pars, const aaDB::AADB& aadb, LadderCache& cache,
+                        bool calcNL, double nlMass = 0, bool labelDecoyNL = false);
         void calcFragments(int minCharge, int maxCharge,
                            const aaDB::AADB& aminoAcidsMasses);
         void addNeutralLoss(double losses, bool labelDecoyNL = false);
@@ -372,13 +359,13 @@ namespace PeptideNamespace{
                 bool printHeader = false, bool printFoundIntensity = false) const;
 
         void setFound(size_t i, bool boo){
-            fragments[i].setFound(boo);
+            found[i] = boo;
         }
         void setFoundMZ(size_t i, double mz){
-            fragments[i].setFoundMZ(mz);
+            foundMZ[i] = mz;
         }
         void setFoundIntensity(size_t i, double intensity){
-            fragments[i].setFoundIntensity(intensity);
+            foundIntensity[i] = intensity;
         }
         void removeUnlabeledFrags();
         void normalizeLabelIntensity(double den);
@@ -392,39 +379,27 @@ namespace PeptideNamespace{
             return fullSequence;
         }
         size_t getNumFragments() const{
-            return fragments.size();
+            return found.size();
         }
         double getFragmentMZ(size_t i) const{
-            return fragments[i].getMZ();
-        }
-        std::string getFragmentLabel(size_t i) const{
-            return fragments[i].getLabel();
-        }
-        std::string getFormatedLabel(size_t i) const{
-            return fragments[i].getFormatedLabel();
+            return fragments->mz[i];
         }
+        std::string getFragmentLabel(size_t i) const;
+        std::string getFormatedLabel(size_t i) const;
         bool getIncludeLabel(size_t i) const{
-            return fragments[i].getIncludeLabel();
-        }
-        template<typename _Tp>
-        std::string getFormatedLabel(size_t i, _Tp num) const{
-            return fragments[i].getFormatedLabel(num);
-        }
-        char getBY(size_t i) const{
-            return fragments[i].getBY();
+            return fragments->includeLabel[i];
         }
+        char getBY(size_t i) const;
         bool getFound(size_t i) const{
-            return fragments[i].getFound();
+            return found[i];
         }
         double getFoundMZ(size_t i) const{
-            return fragments[i].getFoundMZ();
+            return foundMZ[i];
         }
         double getFoundIntensity(size_t i) const{
-            return fragments[i].getFoundIntensity();
-        }
-        const FragmentIon& getFragment(size_t i) const{
-            return fragments[i];
+            return foundIntensity[i];
         }
+        FragmentIon getFragment(size_t i) const;
         int getNumMod() const{
             return nMod;
         }
@@ -435,12 +410,153 @@ namespace PeptideNamespace{
         const std::vector<size_t>& getModLocs() const{
             return modLocs;
         }
-        unsigned int getID() const{
+        std::string getResidueMods() const;
+        //!Get mass of a single neutral loss used to calculate fragments.
+        double getNLMass() const{
+            return fragments ? fragments->nlMass : 0;
+        }
+        std::uint64_t getID() const{
             return _id;
         }
 
     };//end of class
 
+    /**
+     * Used to represent b and y peptide ions. <br>
+     * A FragmentIon is a view of one fragment in a Peptide and is only valid while
+     * the Peptide exists and its fragments are not recalculated or removed.
+     */
+    class FragmentIon{
+    private:
+        const Peptide* _peptide;
+        size_t _i;
+
+        const FragmentArrays& _frags() const{
+            return *_peptide->fragments;
+        }
+    public:
+        FragmentIon(const Peptide& peptide, size_t i){
+            _peptide = &peptide;
+            _i = i;
+        }
+
+        //properties
+        double getMZ() const{
+            return _frags().mz[_i];
+        }
+        int getCharge() const{
+            return _frags().charge[_i];
+        }
+        IonKey getKey() const{
+            return IonKey(getIonType(), getNum(), getCharge(), getNumMod(), getNumNl());
+        }
+        std::string getLabel(bool includeMod = true, std::string chargeSep = " ") const;
+        std::string getFormatedLabel() const;
+        char getBY() const{
+            return ionTypeToBY(getIonType());
+        }
+        //!Get fragment ion number
+        int getNum() const{
+            return _frags().num[_i];
+        }
+        std::string getMod() const;
+        //!Get number of modifications on fragment
+        size_t getNumMod() const{
+            return _frags().nMod[_i];
+        }
+        //!Get number of neutral loss multiples on fragment
+        size_t getNumNl() const{
+            return _frags().numNl[_i];
+        }
+        bool getFound() const{
+            return _peptide->found[_i];
+        }
+        IonType getIonType() const{
+            return _frags().ionType[_i];
+        }
+        bool getIncludeLabel() const{
+            return _frags().includeLabel[_i];
+        }
+        std::string getNLStr() const;
+        bool isModified() const{
+            return getNumMod() > 0;
+        }
+        /**
+         * \return true if fragment is neutral loss ion
+         */
+        bool isNL() const{
+            return getIonType() == IonType::B_NL ||
+                   getIonType() == IonType::Y_NL ||
+                   getIonType() == IonType::M_NL;
+        }
+        /**
+         * \return true if fragment is parent ion or parent neutral loss
+         */
+        bool isM() const{
+            return getIonType() == IonType::M || getIonType() == IonType::M_NL;
+        }
+        //!Get sequence of fragment
+        std::string getSequence() const{
+            return _peptide->sequence.substr(getBegin(), getEnd() - getBegin() + 1);
+        }
+        size_t getBegin() const{
+            return _frags().beg[_i];
+        }
+        size_t getEnd() const{
+            return _frags().end[_i];
+        }
+        double getFoundIntensity() const{
+            return _peptide->foundIntensity[_i];
+        }
+        double getFoundMZ() const{
+            return _peptide->foundMZ[_i];
+        }
+    };
+
+    inline FragmentIon Peptide::getFragment(size_t i) const{
+        return FragmentIon(*this, i);
+    }
+    inline std::string Peptide::getFragmentLabel(size_t i) const{
+        return getFragment(i).getLabel();
+    }
+    inline std::string Peptide::getFormatedLabel(size_t i) const{
+        return getFragment(i).getFormatedLabel();
+    }
+    inline char Peptide::getBY(size_t i) const{
+        return getFragment(i).getBY();
+    }
+
+    /**
+     * Thread safe cache of initialized Peptides and their fragment ladders.
+     * Peptides are keyed by full sequence, fragment charge range, neutral loss settings
+     * and aaDB::AADB::fingerprint, so PSMs of the same peptide share one ladder.
+     */
+    class LadderCache{
+    private:
+        typedef std::unordered_map<std::string, std::shared_ptr<const Peptide> > MapType;
+        MapType _peptides;
+        mutable std::mutex _mutex;
+        //!Maximum number of peptides to hold. 0 to disable the cache.
+        size_t _maxSize;
+    public:
+        explicit LadderCache(size_t maxSize = DEFAULT_LADDER_CACHE_SIZE){
+            _maxSize = maxSize;
+        }
+
+        static std::string makeKey(const std::string& fullSequence, int minCharge, int maxCharge,
+                                   bool calcNL, double nlMass, bool labelDecoyNL, const aaDB::AADB& aadb);
+        std::shared_ptr<const Peptide> find(const std::string& key) const;
+        void insert(const std::string& key, const Peptide& peptide);
+
+        bool enabled() const{
+            return _maxSize > 0;
+        }
+        size_t size() const{
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _peptides.size();
+        }
+    };
+
 }//end of namespace
 
 #endif /* peptide_hpp */
@@ -0,0 +1,227 @@
+//
+// scanIndex.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_scanIndex_hpp
+#define ionfinder_scanIndex_hpp
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <sys/stat.h>
+
+#include <utils.hpp>
+#include <mappedFile.hpp>
+#include <gzipStream.hpp>
+
+namespace ms2 {
+
+    //! Extension appended to MS file names to get the name of their scan index.
+    std::string const SCAN_INDEX_EXT = ".ifidx";
+    //! Incremented whenever the scan index format changes so stale indices are rebuilt.
+    int const SCAN_INDEX_VERSION = 1;
+    std::string const SCAN_INDEX_HEADER = "#ionFinder_scan_index";
+
+    bool getXmlAttribute(const std::string& text, size_t begin, size_t end,
+                         const std::string& name, std::string& value);
+    bool hasCvParam(const std::string& text, size_t begin, size_t end, const std::string& accession);
+    bool getCvParam(const std::string& text, size_t begin, size_t end,
+                    const std::string& accession, std::string& value);
+    size_t scanNumFromNativeId(const std::string& id);
+
+    /**
+     * Share of the process wide limit on extra threads used to index and decode MS files,
+     * and the worker threads using it. <br>
+     * Files loaded at the same time by search workers and prefetch I/O threads share the limit,
+     * so the number of threads does not grow with the number of concurrent loads.
+     * The calling thread is not counted against the limit, so every load can use at least one thread.
+     * Workers are started the first time a job is run and are reused by every later job,
+     * so one object should be kept for the whole load of a file.
+     */
+    class DecodeThreads {
+    public:
+        //! Called once for each item in a job.
+        typedef std::function<void(size_t)> Job;
+    private:
+        static std::mutex mutex;
+        //! Maximum number of extra threads in use by all loads.
+        static unsigned int _limit;
+        //! Number of extra threads currently in use.
+        static unsigned int _inUse;
+        //! Extra threads held by this object.
+        unsigned int _extra;
+
+        std::vector<std::thread> _workers;
+        //! Guards the job state below.
+        std::mutex jobMutex;
+        //! Signals workers that a job was started or that they should stop.
+        std::condition_variable jobCv;
+        //! Signals wait that the workers are done with the current job.
+        std::condition_variable doneCv;
+        Job _job;
+        size_t _nItems;
+        std::atomic<size_t> _nextItem;
+        //! Incremented each time a job is started.
+        uint64_t _generation;
+        //! Number of workers still running the current job.
+        unsigned int _running;
+        bool _stop;
+
+        void workerLoop();
+        void runItems();
+    public:
+        explicit DecodeThreads(unsigned int wanted);
+        DecodeThreads(const DecodeThreads&) = delete;
+        DecodeThreads& operator = (const DecodeThreads&) = delete;
+        ~DecodeThreads();
+
+        //! Number of threads which can be used, including the calling thread.
+        unsigned int size() const {
+            return _extra + 1;
+        }
+        void start(size_t nItems, const Job& job);
+        void wait();
+        /**
+         * Run \p job for each item in [0, \p nItems) on the workers and the calling thread.
+         * @param nItems Number of items.
+         * @param job Called once for each item.
+         */
+        void run(size_t nItems, const Job& job) {
+            start(nItems, job);
+            wait();
+        }
+        static void setLimit(unsigned int limit);
+    };
+
+    /**
+     * Index of the scans in an MS file.
+     * Maps each scan number to the position of the scan in the file along with its precursor m/z,
+     * retention time and charge. The index is stored next to the MS file in a sidecar file so
+     * the MS file only has to be parsed in full the first time it is read.
+     * The sidecar is validated against the size and modification time of the MS file.
+     */
+    class ScanIndex {
+    public:
+        enum class FileType {MS2, MZXML, MZML, UNKNOWN};
+
+        //! Location and precursor data for a single scan.
+        struct Entry {
+            size_t scanNum;
+            //! Byte offset of the first character of the scan.
+            uint64_t offset;
+            //! Number of bytes in the scan.
+            uint64_t length;
+            std::string precursorMZ;
+            //! Retention time in minutes.
+            double rt;
+            int charge;
+            Entry() : scanNum(0), offset(0), length(0), precursorMZ(""), rt(0), charge(0) {}
+
+            bool operator < (const Entry& rhs) const {
+                return scanNum < rhs.scanNum;
+            }
+        };
+        typedef std::vector<Entry> EntryList;
+
+    private:
+        std::string _fname;
+        FileType _fileType;
+        //! Size of the MS file when the index was built.
+        uint64_t _fileSize;
+        //! Modification time of the MS file when the index was built.
+        int64_t _fileMTime;
+        //! Entries sorted by scan number.
+        EntryList _entries;
+
+        static bool readOffsetIndex(FileType fileType, const char* begin, const char* end,
+                                    std::vector<uint64_t>& starts);
+        static void findScanStarts(FileType fileType, const char* begin, const char* end,
+                                   DecodeThreads& threads, std::vector<uint64_t>& starts);
+        static bool buildRange(FileType fileType, const char* fileBegin, const char* begin, const char* end,
+                               EntryList& entries);
+        static bool buildMs2(const char* fileBegin, const char* begin, const char* end, EntryList& entries);
+        static bool buildMzXML(const char* fileBegin, const char* begin, const char* end, EntryList& entries);
+        static bool buildMzML(const char* fileBegin, const char* begin, const char* end, EntryList& entries);
+
+    public:
+        ScanIndex() {
+            _fname = "";
+            _fileType = FileType::UNKNOWN;
+            _fileSize = 0;
+            _fileMTime = 0;
+        }
+
+        static FileType getFileType(const std::string& fname);
+        static bool getFileStats(const std::string& fname, uint64_t& size, int64_t& mtime);
+        static std::string sidecarName(const std::string& fname) {
+            return fname + SCAN_INDEX_EXT;
+        }
+
+        bool build(const std::string& fname, unsigned int nThread = 1);
+        bool build(const std::string& fname, DecodeThreads& threads);
+        bool build(const std::string& fname, const char* begin, const char* end, unsigned int nThread = 1);
+        bool build(const std::string& fname, const char* begin, const char* end, DecodeThreads& threads);
+        bool readSidecar(const std::string& fname);
+        bool writeSidecar() const;
+        bool load(const std::string& fname, unsigned int nThread = 1);
+        bool load(const std::string& fname, DecodeThreads& threads);
+        bool load(const std::string& fname, const char* begin, const char* end, unsigned int nThread = 1);
+        bool load(const std::string& fname, const char* begin, const char* end, DecodeThreads& threads);
+
+        const Entry* find(size_t scanNum) const;
+        FileType getFileType() const {
+            return _fileType;
+        }
+        const std::string& getFileName() const {
+            return _fname;
+        }
+        const EntryList& getEntries() const {
+            return _entries;
+        }
+        size_t size() const {
+            return _entries.size();
+        }
+        //! Approximate bytes used by the index.
+        size_t memoryUsage() const {
+            return _entries.capacity() * sizeof(Entry);
+        }
+    };
+}
+
+#endif //ionfinder_scanIndex_hpp
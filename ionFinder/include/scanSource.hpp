@@ -0,0 +1,142 @@
+//
+// scanSource.hpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#ifndef ionfinder_scanSource_hpp
+#define ionfinder_scanSource_hpp
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <msInterface/msInterface.hpp>
+#include <msInterface/ms2File.hpp>
+#include <msInterface/mzXMLFile.hpp>
+#include <msInterface/mzMLFile.hpp>
+#include <ms2Spectrum.hpp>
+#include <scanIndex.hpp>
+#include <peakFilter.hpp>
+
+namespace ms2 {
+
+    //! Options controlling how MS files are read by MsInterface.
+    struct ReaderOptions {
+        //! Use a persistent scan index to seek to requested scans instead of parsing whole files.
+        bool scanIndex;
+        //! Memory map .ms2 files and only parse the scans which are requested.
+        bool mmap;
+        //! Maximum bytes of MS data held in memory at once. 0 for no limit.
+        size_t maxMemory;
+        //! Read from an up to date binary cache written by the cache subcommand when there is one.
+        bool binaryCache;
+        //! Number of threads used to decode the scans of a single file.
+        unsigned int decodeThreads;
+        //! Peaks removed from each scan as it is read.
+        PeakFilter peakFilter;
+        ReaderOptions() : scanIndex(false), mmap(false), maxMemory(0), binaryCache(true), decodeThreads(1) {}
+    };
+
+    /**
+     * Interface for an MS file held in MsInterface.
+     * Implementations must allow getScan to be called from several threads at once after read has returned.
+     */
+    class ScanSource {
+    protected:
+        //! Applied to the ions of each scan before they are stored or copied into a Spectrum.
+        PeakFilter _peakFilter;
+    public:
+        virtual ~ScanSource() {}
+
+        //! Set the filter applied to scans. Must be called before read.
+        void setPeakFilter(const PeakFilter& peakFilter) {
+            _peakFilter = peakFilter;
+        }
+
+        /**
+         * Prepare \p fname for reading scans.
+         * @param fname Path to MS file.
+         * @return true if all file I/O was successful.
+         */
+        virtual bool read(const std::string& fname) = 0;
+
+        /**
+         * Prepare \p fname for reading scans when the scans which will be requested are known.
+         * Implementations may skip decoding scans which are not in \p scans.
+         * The default implementation ignores \p scans.
+         * @param fname Path to MS file.
+         * @param scans Sorted list of scan numbers which will be requested.
+         * @return true if all file I/O was successful.
+         */
+        virtual bool read(const std::string& fname, const std::vector<size_t>& scans) {
+            (void)scans;
+            return read(fname);
+        }
+
+        /**
+         * Get a scan from the file.
+         * @param scanNum Scan number to retrieve.
+         * @param scan Spectrum to populate.
+         * @return true if the scan was found.
+         */
+        virtual bool getScan(size_t scanNum, ms2::Spectrum& scan) const = 0;
+
+        /**
+         * Estimate of the memory needed to read \p fname, used to reserve memory before it is read.
+         * The default implementation uses the size of the file on disk.
+         * @param fname Path to MS file.
+         * @return Estimate in bytes.
+         */
+        virtual size_t estimateMemory(const std::string& fname) const {
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            return ScanIndex::getFileStats(fname, size, mtime) ? (size_t)size : 0;
+        }
+
+        //! Approximate bytes of memory held after read has returned.
+        virtual size_t memoryUsage() const = 0;
+    };
+
+    /**
+     * ScanSource which parses the entire file into memory with the peptideUtils readers.
+     */
+    class UtilsScanSource : public ScanSource {
+        typedef utils::msInterface::MsInterface MsFile;
+        std::unique_ptr<MsFile> _file;
+        //! The parsed file is not inspected, so its size on disk is used as its memory use.
+        size_t _memory;
+    public:
+        UtilsScanSource() : _file(nullptr), _memory(0) {}
+        bool read(const std::string& fname) override;
+        bool getScan(size_t scanNum, ms2::Spectrum& scan) const override;
+        size_t memoryUsage() const override {
+            return _memory;
+        }
+    };
+
+    std::shared_ptr<ScanSource> makeScanSource(const std::string& fname, const ReaderOptions& options);
+}
+
+#endif //ionfinder_scanSource_hpp
@@ -41,35 +41,28 @@ aaDB::AminoAcid::AminoAcid(std::string line)
     modification = 0;
 }
 
-void aaDB::AADB::initAADB()
+/**
+ * Get the AADB with default masses.
+ * The table is filled from DEFAULT_RESIDUE_MASSES the first time it is needed.
+ * @return AADB with no static modifications.
+ */
+const aaDB::AADB& aaDB::AADB::defaultAADB()
 {
-    aminoAcidsDB["C_term"]= aaDB::AminoAcid("C_term", 17.00325);
-    aminoAcidsDB["N_term"] = aaDB::AminoAcid("N_term", 1.00732);
-    aminoAcidsDB["A"] = aaDB::AminoAcid("A", 71.03712);
-    aminoAcidsDB["C"] = aaDB::AminoAcid("C", 103.00918);
-    aminoAcidsDB["D"] = aaDB::AminoAcid("D", 115.02694);
-    aminoAcidsDB["E"] = aaDB::AminoAcid("E", 129.0426);
-    aminoAcidsDB["F"] = aaDB::AminoAcid("F", 147.06841);
-    aminoAcidsDB["G"] = aaDB::AminoAcid("G", 57.02146);
-    aminoAcidsDB["H"] = aaDB::AminoAcid("H", 137.05891);
-    aminoAcidsDB["I"] = aaDB::AminoAcid("I", 113.08407);
-    aminoAcidsDB["K"] = aaDB::AminoAcid("K", 128.09496);
-    aminoAcidsDB["L"] = aaDB::AminoAcid("L", 113.08406);
-    aminoAcidsDB["M"] = aaDB::AminoAcid("M", 131.04049);
-    aminoAcidsDB["N"] = aaDB::AminoAcid("N", 114.04293);
-    aminoAcidsDB["O"] = aaDB::AminoAcid("O", 114.07931);
-    aminoAcidsDB["P"] = aaDB::AminoAcid("P", 97.05276);
-    aminoAcidsDB["Q"] = aaDB::AminoAcid("Q", 128.05858);
-    aminoAcidsDB["R"] = aaDB::AminoAcid("R", 156.10111);
-    aminoAcidsDB["S"] = aaDB::AminoAcid("S", 87.03203);
-    aminoAcidsDB["T"] = aaDB::AminoAcid("T", 101.04768);
-    aminoAcidsDB["V"] = aaDB::AminoAcid("V", 99.06841);
-    aminoAcidsDB["W"] = aaDB::AminoAcid("W", 186.07931);
-    aminoAcidsDB["Y"] = aaDB::AminoAcid("Y", 163.06333);
-    aminoAcidsDB["U"] = aaDB::AminoAcid("U", 150.95309);
-    aminoAcidsDB["*"] = aaDB::AminoAcid("*", 0);
-    aminoAcidsDB["@"] = aaDB::AminoAcid("@", 0);
-    aminoAcidsDB["&"] = aaDB::AminoAcid("&", 0);
+    static const AADB defaults = [](){
+        AADB ret;
+        ret.setMass(C_TERM_SLOT, DEFAULT_C_TERM_MASS);
+        ret.setMass(N_TERM_SLOT, DEFAULT_N_TERM_MASS);
+        for(const ResidueMass& residue : DEFAULT_RESIDUE_MASSES)
+            ret.setMass((unsigned char)residue.symbol, residue.mass);
+        ret.updateFingerprint();
+        return ret;
+    }();
+    return defaults;
+}
+
+//! Reset to default masses by copying the shared default table.
+void aaDB::AADB::initAADB(){
+    *this = defaultAADB();
 }
 
 bool aaDB::AADB::readInModDB(std::string _modDBLoc, aaDB::aminoAcidsDBType& modsTemp)
@@ -98,9 +91,36 @@ bool aaDB::AADB::readInModDB(std::string _modDBLoc, aaDB::aminoAcidsDBType& mods
 	return true;
 }// end of function
 
+/**
+ * Get index of \p symbol in mass table.
+ * @param symbol Single residue char, "N_term" or "C_term".
+ * @return Index or N_MASS_SLOTS if \p symbol can not be in the table.
+ */
+size_t aaDB::AADB::getSlot(const std::string& symbol)
+{
+    if(symbol.length() == 1)
+        return (unsigned char)symbol[0];
+    if(symbol == "N_term")
+        return N_TERM_SLOT;
+    if(symbol == "C_term")
+        return C_TERM_SLOT;
+    return N_MASS_SLOTS;
+}
+
+//! Set unmodified mass of \p slot.
+void aaDB::AADB::setMass(size_t slot, double mass)
+{
+    if(!_exists[slot]) _size++;
+    _exists[slot] = true;
+    _mass[slot] = mass;
+    _modification[slot] = 0;
+    _totalMass[slot] = mass;
+}
+
 //! Check if amino acid or modification exists in AADB.
-bool aaDB::AADB::aaExists(std::string aa) const {
-    return aminoAcidsDB.find(aa) != aminoAcidsDB.end();
+bool aaDB::AADB::aaExists(const std::string& aa) const {
+    size_t slot = getSlot(aa);
+    return slot < N_MASS_SLOTS && _exists[slot];
 }
 
 /**
@@ -109,15 +129,24 @@ bool aaDB::AADB::aaExists(std::string aa) const {
  * @throws std::rumtime_error if aa.symbol does not exist in AADB
  */
 void aaDB::AADB::addMod(const AminoAcid& aa) {
+    applyMod(aa);
+    updateFingerprint();
+}
+
+//! Add modification mass in \p aa without updating the fingerprint.
+void aaDB::AADB::applyMod(const AminoAcid& aa) {
     std::string tempSymbol = aa.getSymbol();
     if(!aaExists(tempSymbol))
         throw std::runtime_error("Unknown modification: " + tempSymbol);
-    else aminoAcidsDB[tempSymbol].addMod(aa.getMass());
+    size_t slot = getSlot(tempSymbol);
+    _modification[slot] += aa.getMass();
+    _totalMass[slot] = _mass[slot] + _modification[slot];
 }
 
 void aaDB::AADB::addStaticMod(const aaDB::aminoAcidsDBType& modsTemp) {
 	for(const auto & it : modsTemp)
-		addMod(it.second);
+		applyMod(it.second);
+	updateFingerprint();
 }
 
 /**
@@ -154,52 +183,80 @@ void aaDB::AADB::initialize(){
 }
 
 void aaDB::AADB::clear(){
-    aminoAcidsDB.clear();
+    for(size_t i = 0; i < N_MASS_SLOTS; i++){
+        _exists[i] = false;
+        _mass[i] = 0;
+        _modification[i] = 0;
+        _totalMass[i] = 0;
+    }
+    _size = 0;
+    updateFingerprint();
 }
 
-double aaDB::AADB::getMW(std::string aa) const
+//! Recalculate AADB::_fingerprint as a 64 bit FNV-1a hash of every slot and mass.
+void aaDB::AADB::updateFingerprint()
 {
-	auto it = aminoAcidsDB.find(aa);
-	if(it == aminoAcidsDB.end())
-		return -1;
-	return it->second.getMass();
+    std::uint64_t hash = 14695981039346656037ULL;
+    auto add = [&hash](const char* data, size_t len){
+        for(size_t i = 0; i < len; i++){
+            hash ^= (unsigned char)data[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    for(size_t i = 0; i < N_MASS_SLOTS; i++){
+        if(!_exists[i]) continue;
+        char bytes[sizeof(size_t) + sizeof(double)];
+        std::memcpy(bytes, &i, sizeof(size_t));
+        std::memcpy(bytes + sizeof(size_t), &_totalMass[i], sizeof(double));
+        add(bytes, sizeof(bytes));
+    }
+    _fingerprint = hash;
 }
 
-double aaDB::AADB::getMW(char aa) const
+/**
+ * Get mass of residue or terminus.
+ * @param aa Single residue char, "N_term" or "C_term".
+ * @return Mass of \p aa or -1 if \p aa is not in AADB.
+ */
+double aaDB::AADB::getMW(const std::string& aa) const
 {
-	return getMW(std::string(1, aa));
+	size_t slot = getSlot(aa);
+	if(slot >= N_MASS_SLOTS || !_exists[slot])
+		return -1;
+	return _totalMass[slot];
 }
 
-double aaDB::AADB::calcMW(std::string sequence, bool addNTerm, bool addCTerm) const
+/**
+ * Calculate mass of \p sequence.
+ * @param sequence Sequence of residues with no modification symbols.
+ * @param addNTerm Should N terminus be added?
+ * @param addCTerm Should C terminus be added?
+ * @return Mass of \p sequence or -1 if it contains a residue which is not in AADB.
+ */
+double aaDB::AADB::calcMW(const std::string& sequence, bool addNTerm, bool addCTerm) const
 {
 	double mass = 0;
-	size_t len = sequence.length();
-	double temp;
 	
 	if(addNTerm)
 	{
-		temp = getMW("N_term");
-		if(temp == -1)
+		if(!_exists[N_TERM_SLOT])
 			return -1;
-		mass += temp;
+		mass += _totalMass[N_TERM_SLOT];
 	}
 	
-	for(size_t i = 0; i < len; i++)
+	for(char c : sequence)
 	{
-		temp = getMW(sequence[i]);
-		if(temp == -1)
+		size_t slot = (unsigned char)c;
+		if(!_exists[slot])
 			return -1;
-		mass += temp;
+		mass += _totalMass[slot];
 	}
 	if(addCTerm)
 	{
-		temp = getMW("C_term");
-		if(temp == -1)
+		if(!_exists[C_TERM_SLOT])
 			return -1;
-		mass += temp;
+		mass += _totalMass[C_TERM_SLOT];
 	}
 	
 	return mass;
 }
-
-
@@ -0,0 +1,225 @@
+//
+// binaryCache.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <binaryCache.hpp>
+
+/**
+ * Check that \p header was written by this version of the program on a machine with the same byte order
+ * and that the MS file \p fname has not changed since the cache was written.
+ * If the MS file no longer exists the cache is still used.
+ * @param header Cache header.
+ * @param fname Path to MS file.
+ * @return true if the cache can be used.
+ */
+bool ms2::BinaryCacheFile::checkHeader(const Header& header, const std::string& fname)
+{
+    if(std::memcmp(header.magic, BINARY_CACHE_MAGIC, sizeof(BINARY_CACHE_MAGIC)) != 0 ||
+       header.version != BINARY_CACHE_VERSION ||
+       header.byteOrder != BINARY_CACHE_BYTE_ORDER)
+        return false;
+
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if(ScanIndex::getFileStats(fname, size, mtime))
+        return size == header.sourceSize && mtime == header.sourceMTime;
+    return true;
+}
+
+/**
+ * Check whether there is an up to date binary cache for \p fname.
+ * @param fname Path to MS file.
+ * @return true if the cache exists and can be used.
+ */
+bool ms2::BinaryCacheFile::isCurrent(const std::string& fname)
+{
+    std::ifstream inF(cacheName(fname), std::ios::binary);
+    if(!inF) return false;
+    Header header;
+    if(!inF.read((char*)&header, sizeof(Header))) return false;
+    return checkHeader(header, fname);
+}
+
+/**
+ * Write a binary cache of the MS file \p fname.
+ * The MS file is parsed with IndexedMsFile, so any file type with a ScanIndex is supported.
+ * The scan index is built in memory and is not written to a sidecar.
+ * The cache is written to a temporary file which is renamed when it is complete,
+ * so a partially written cache is never read.
+ * @param fname Path to MS file.
+ * @param ofname Path to write cache to.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::BinaryCacheFile::write(const std::string& fname, const std::string& ofname)
+{
+    //the index is only needed while the cache is written, so no sidecar is left next to the MS file
+    IndexedMsFile msFile(1, false);
+    if(!msFile.read(fname)) return false;
+
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, BINARY_CACHE_MAGIC, sizeof(BINARY_CACHE_MAGIC));
+    header.version = BINARY_CACHE_VERSION;
+    header.byteOrder = BINARY_CACHE_BYTE_ORDER;
+    header.fileType = (uint32_t)msFile.getIndex().getFileType();
+    if(!ScanIndex::getFileStats(fname, header.sourceSize, header.sourceMTime))
+        return false;
+    header.nScans = msFile.getIndex().size();
+
+    std::string tempName = ofname + ".tmp";
+    std::ofstream outF(tempName, std::ios::binary | std::ios::trunc);
+    if(!outF) return false;
+
+    //peak data starts after the header and scan table, which are written last
+    std::vector<ScanHeader> scans;
+    scans.reserve((size_t)header.nScans);
+    uint64_t offset = sizeof(Header) + header.nScans * sizeof(ScanHeader);
+    outF.seekp((std::streamoff)offset);
+
+    std::string strings;
+    std::vector<float> column;
+    bool success = msFile.forEachScan([&](const ScanIndex::Entry& entry, const PrecursorScan& precursor,
+                                          const std::vector<ScanIon>& ions) -> bool {
+        ScanHeader scan;
+        std::memset(&scan, 0, sizeof(ScanHeader));
+        scan.scanNum = entry.scanNum;
+        scan.peaksOffset = offset;
+        scan.nPeaks = ions.size();
+        scan.rt = precursor.getRT();
+        scan.precursorIntensity = precursor.getIntensity();
+        scan.charge = precursor.getCharge();
+
+        std::string value = precursor.getMZ();
+        scan.mzOffset = (uint32_t)strings.size();
+        scan.mzLength = (uint32_t)value.size();
+        strings += value;
+        value = precursor.getScan();
+        scan.precursorScanOffset = (uint32_t)strings.size();
+        scan.precursorScanLength = (uint32_t)value.size();
+        strings += value;
+        scans.push_back(scan);
+
+        column.resize(ions.size());
+        for(size_t i = 0; i < ions.size(); i++)
+            column[i] = (float)ions[i].getMZ();
+        outF.write((const char*)column.data(), (std::streamsize)(column.size() * sizeof(float)));
+        for(size_t i = 0; i < ions.size(); i++)
+            column[i] = (float)ions[i].getIntensity();
+        outF.write((const char*)column.data(), (std::streamsize)(column.size() * sizeof(float)));
+        offset += ions.size() * sizeof(float) * 2;
+        return (bool)outF;
+    });
+
+    if(success) {
+        header.stringsOffset = offset;
+        header.stringsSize = strings.size();
+        outF.write(strings.data(), (std::streamsize)strings.size());
+
+        std::sort(scans.begin(), scans.end(), [](const ScanHeader& lhs, const ScanHeader& rhs){
+            return lhs.scanNum < rhs.scanNum;
+        });
+        outF.seekp(0);
+        outF.write((const char*)&header, sizeof(Header));
+        outF.write((const char*)scans.data(), (std::streamsize)(scans.size() * sizeof(ScanHeader)));
+        success = (bool)outF;
+    }
+    outF.close();
+
+    if(!success || std::rename(tempName.c_str(), ofname.c_str()) != 0) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Map the binary cache of \p fname.
+ * @param fname Path to MS file. The cache is read from cacheName(fname).
+ * @return true if the cache was mapped and is up to date.
+ */
+bool ms2::BinaryCacheFile::read(const std::string& fname)
+{
+    _fname = fname;
+    if(!_file.open(cacheName(fname))) return false;
+    if(_file.size() < sizeof(Header)) return false;
+
+    _header = (const Header*)_file.data();
+    if(!checkHeader(*_header, fname)) return false;
+    if(sizeof(Header) + _header->nScans * sizeof(ScanHeader) > _file.size() ||
+       _header->stringsOffset + _header->stringsSize > _file.size())
+        return false;
+
+    _scans = (const ScanHeader*)(_file.data() + sizeof(Header));
+    _strings = _file.data() + _header->stringsOffset;
+
+    //scans are requested in no particular order
+    _file.advise(MappedFile::Advice::RANDOM);
+    return true;
+}
+
+std::string ms2::BinaryCacheFile::getString(uint32_t offset, uint32_t length) const
+{
+    if((uint64_t)offset + length > _header->stringsSize) return "";
+    return std::string(_strings + offset, length);
+}
+
+/**
+ * Get a single scan from the mapped cache.
+ * This function is thread safe.
+ * @param scanNum Scan number to retrieve.
+ * @param scan Spectrum to populate.
+ * @return true if the scan was found.
+ */
+bool ms2::BinaryCacheFile::getScan(size_t scanNum, ms2::Spectrum& scan) const
+{
+    if(!_header) return false;
+    const ScanHeader* end = _scans + _header->nScans;
+    const ScanHeader* it = std::lower_bound(_scans, end, scanNum, [](const ScanHeader& lhs, size_t rhs){
+        return lhs.scanNum < rhs;
+    });
+    if(it == end || it->scanNum != scanNum) return false;
+    if(it->peaksOffset + it->nPeaks * sizeof(float) * 2 > _header->stringsOffset) return false;
+
+    PrecursorScan precursor;
+    precursor.setFile(_fname);
+    precursor.setMZ(getString(it->mzOffset, it->mzLength));
+    precursor.setScan(getString(it->precursorScanOffset, it->precursorScanLength));
+    precursor.setRT(it->rt);
+    precursor.setCharge(it->charge);
+    precursor.setIntensity(it->precursorIntensity);
+
+    const float* mz = (const float*)(_file.data() + it->peaksOffset);
+    const float* intensity = mz + it->nPeaks;
+    std::vector<ScanIon> ions((size_t)it->nPeaks);
+    for(size_t i = 0; i < ions.size(); i++) {
+        ions[i].setMZ(mz[i]);
+        ions[i].setIntensity(intensity[i]);
+    }
+    _peakFilter.apply(ions);
+
+    scan.assign(scanNum, precursor, ions);
+    return true;
+}
@@ -0,0 +1,223 @@
+//
+// binaryData.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <binaryData.hpp>
+#include <config.h>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+    //! Value of each base64 character or -1 for characters outside the alphabet.
+    struct Base64Table {
+        int8_t values[256];
+        Base64Table() {
+            const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for(int i = 0; i < 256; i++) values[i] = -1;
+            for(int i = 0; i < 64; i++) values[(unsigned char)alphabet[i]] = (int8_t)i;
+        }
+    };
+    const Base64Table BASE64_TABLE;
+}
+
+/**
+ * Decode base64 text between \p begin and \p end. Whitespace is skipped.
+ * Groups of 4 characters are decoded to 3 bytes at a time until padding or whitespace is reached,
+ * after which the remaining characters are decoded one at a time.
+ * @param begin Beginning of encoded text.
+ * @param end End of encoded text.
+ * @param out Decoded bytes.
+ * @return false if an invalid character was found.
+ */
+bool ms2::base64Decode(const char* begin, const char* end, std::string& out)
+{
+    out.resize((size_t)(end - begin) / 4 * 3 + 3);
+    unsigned char* dest = (unsigned char*)&out[0];
+    const unsigned char* c = (const unsigned char*)begin;
+    const unsigned char* const last = (const unsigned char*)end;
+
+    //fast path for whole groups of 4 characters
+    const int8_t* const table = BASE64_TABLE.values;
+    while(last - c >= 4) {
+        int32_t const a = table[c[0]], b = table[c[1]], d = table[c[2]], e = table[c[3]];
+        //any negative value sets the sign bit
+        if((a | b | d | e) < 0) break;
+        uint32_t const group = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)d << 6) | (uint32_t)e;
+        dest[0] = (unsigned char)(group >> 16);
+        dest[1] = (unsigned char)(group >> 8);
+        dest[2] = (unsigned char)group;
+        dest += 3;
+        c += 4;
+    }
+
+    //padding, whitespace or a partial group
+    uint32_t buffer = 0;
+    int nBits = 0;
+    for(; c != last; ++c) {
+        if(*c == '=') break;
+        if(isspace(*c)) continue;
+        int value = table[*c];
+        if(value < 0) return false;
+        buffer = (buffer << 6) | (uint32_t)value;
+        nBits += 6;
+        if(nBits >= 8) {
+            nBits -= 8;
+            *dest++ = (unsigned char)((buffer >> nBits) & 0xFF);
+        }
+    }
+    out.resize((size_t)(dest - (unsigned char*)&out[0]));
+    return true;
+}
+
+/**
+ * Decompress zlib compressed data.
+ * Data is inflated directly into \p out, which grows if \p expectedSize is too small.
+ * @param in Compressed bytes.
+ * @param out Decompressed bytes.
+ * @param expectedSize Expected size of the decompressed data or 0 if unknown.
+ * @return true if successful.
+ */
+bool ms2::zlibDecompress(const std::string& in, std::string& out, size_t expectedSize)
+{
+#ifdef ENABLE_ZLIB
+    out.resize(std::max(expectedSize, in.size() * 2) + 16);
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = (Bytef*)in.data();
+    stream.avail_in = (uInt)in.size();
+    if(inflateInit(&stream) != Z_OK) return false;
+
+    int ret = Z_OK;
+    while(ret != Z_STREAM_END) {
+        if(stream.total_out == out.size())
+            out.resize(out.size() * 2);
+        stream.next_out = (Bytef*)&out[stream.total_out];
+        stream.avail_out = (uInt)(out.size() - stream.total_out);
+        ret = inflate(&stream, Z_NO_FLUSH);
+        if(ret != Z_OK && ret != Z_STREAM_END) {
+            inflateEnd(&stream);
+            return false;
+        }
+    }
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+    return true;
+#else
+    std::cerr << "ionFinder was built without zlib. Can not decompress binary data!" << NEW_LINE;
+    return false;
+#endif
+}
+
+/**
+ * Convert an array of raw IEEE floats to doubles.
+ * @param bytes Raw bytes.
+ * @param precision 32 or 64.
+ * @param byteOrder Byte order of \p bytes.
+ * @param out Decoded values.
+ * @return false if \p precision is not supported or \p bytes is not a multiple of the value size.
+ */
+bool ms2::decodeFloats(const std::string& bytes, int precision, ByteOrder byteOrder, std::vector<double>& out)
+{
+    if(precision != 32 && precision != 64) return false;
+    size_t const width = (size_t)precision / 8;
+    if(bytes.size() % width != 0) return false;
+
+    size_t const n = bytes.size() / width;
+    out.resize(n);
+
+    //values are already in host byte order so they can be copied and widened directly
+    if(byteOrder == hostByteOrder()) {
+        if(precision == 64) {
+            std::memcpy(out.data(), bytes.data(), n * sizeof(double));
+        }
+        else {
+            std::vector<float> values(n);
+            std::memcpy(values.data(), bytes.data(), n * sizeof(float));
+            for(size_t i = 0; i < n; i++)
+                out[i] = values[i];
+        }
+        return true;
+    }
+
+    const unsigned char* data = (const unsigned char*)bytes.data();
+    for(size_t i = 0; i < n; i++) {
+        const unsigned char* value = data + i * width;
+        uint64_t bits = 0;
+        for(size_t b = 0; b < width; b++) {
+            size_t shift = byteOrder == ByteOrder::LITTLE_ENDIAN_ORDER ? b : width - 1 - b;
+            bits |= (uint64_t)value[b] << (8 * shift);
+        }
+        if(precision == 32) {
+            uint32_t bits32 = (uint32_t)bits;
+            float f;
+            std::memcpy(&f, &bits32, sizeof(f));
+            out[i] = f;
+        }
+        else {
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            out[i] = d;
+        }
+    }
+    return true;
+}
+
+//! Byte order of the machine the program is running on.
+ms2::ByteOrder ms2::hostByteOrder()
+{
+    uint16_t const value = 1;
+    unsigned char first;
+    std::memcpy(&first, &value, 1);
+    return first == 1 ? ByteOrder::LITTLE_ENDIAN_ORDER : ByteOrder::BIG_ENDIAN_ORDER;
+}
+
+/**
+ * Decode a base64 encoded and optionally zlib compressed array of floats.
+ * @param begin Beginning of encoded text.
+ * @param end End of encoded text.
+ * @param precision 32 or 64.
+ * @param byteOrder Byte order of the decoded floats.
+ * @param zlib Is the array zlib compressed?
+ * @param out Decoded values.
+ * @param expectedLength Expected number of values or 0 if unknown. Used to size the zlib buffer.
+ * @return true if successful.
+ */
+bool ms2::decodeBinaryArray(const char* begin, const char* end, int precision, ByteOrder byteOrder,
+                            bool zlib, std::vector<double>& out, size_t expectedLength)
+{
+    std::string bytes;
+    if(!base64Decode(begin, end, bytes)) return false;
+    if(zlib) {
+        std::string inflated;
+        if(!zlibDecompress(bytes, inflated, expectedLength * (size_t)precision / 8)) return false;
+        bytes.swap(inflated);
+    }
+    return decodeFloats(bytes, precision, byteOrder, out);
+}
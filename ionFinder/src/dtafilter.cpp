@@ -96,7 +96,30 @@ bool Dtafilter::readFilterFile(const std::string& fname,
 							   bool skipReverse,
 							   int modFilter)
 {
-	std::ifstream inF(fname);
+	return Dtafilter::readFilterFile(fname, sampleName, [&scans](Dtafilter::Scan& scan) -> bool {
+		scans.push_back(scan);
+		return true;
+	}, skipReverse, modFilter);
+}
+
+/**
+ Read DTAFilter-file and pass each scan to \p callback as it is read.
+ \param fname File name
+ \param sampleName Sample name to add to _sampleName member of each scan
+ \param callback Called for each scan which passes the filters. If it returns false, reading stops.
+ \param skipReverse Should reverse peptide matches be skipped?
+ \param modFilter Which scans should be passed to \p callback?
+	0: only modified, 1: all peptides regardless of modification, 2: only unmodified pepeitde.
+
+ \return true if file I/O was successful and \p callback never returned false.
+ */
+bool Dtafilter::readFilterFile(const std::string& fname,
+							   const std::string& sampleName,
+							   const ScanCallback& callback,
+							   bool skipReverse,
+							   int modFilter)
+{
+	gzip::IfStream inF(fname);
 	if(!inF) return false;
 	
 	//flow control flags
@@ -159,7 +182,7 @@ bool Dtafilter::readFilterFile(const std::string& fname,
 					   (modFilter == 2 && newScan.isModified()))
 						continue;
 					
-					scans.push_back(newScan);
+					if(!callback(newScan)) return false;
 					
 				}//end of while
 				inF.seekg(sp); //reset streampos so line is not skipped in next iteration
@@ -167,5 +190,10 @@ bool Dtafilter::readFilterFile(const std::string& fname,
 		}//end if
 	}//end while
 	
+	//a compressed file which could not be decompressed ends early
+	if(inF.failed() || inF.bad()){
+		std::cerr << "\nError reading " << fname << NEW_LINE;
+		return false;
+	}
 	return true;
 }
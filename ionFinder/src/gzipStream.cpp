@@ -0,0 +1,290 @@
+//
+// gzipStream.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <gzipStream.hpp>
+#include <config.h>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <iostream>
+#include <stdexcept>
+#include <utils.hpp>
+
+/**
+ * Check whether \p fname begins with the gzip magic bytes.
+ * @param fname Path to file.
+ * @return false if \p fname is not compressed or can not be read.
+ */
+bool gzip::isCompressed(const std::string& fname)
+{
+    std::ifstream inF(fname, std::ios::binary);
+    unsigned char magic[2];
+    if(!inF.read((char*)magic, 2)) return false;
+    return magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+/**
+ * Get the size of the decompressed data from the gzip trailer.
+ * The trailer stores the size modulo 2^32 and only describes the last member of the file,
+ * so the value should only be used as an estimate.
+ * @param fname Path to gzip file.
+ * @return Decompressed size or 0 if it could not be read.
+ */
+uint64_t gzip::uncompressedSize(const std::string& fname)
+{
+    std::ifstream inF(fname, std::ios::binary | std::ios::ate);
+    if(!inF || inF.tellg() < 4) return 0;
+    inF.seekg(-4, std::ios::end);
+    unsigned char bytes[4];
+    if(!inF.read((char*)bytes, 4)) return 0;
+    return (uint64_t)bytes[0] | ((uint64_t)bytes[1] << 8) | ((uint64_t)bytes[2] << 16) | ((uint64_t)bytes[3] << 24);
+}
+
+/**
+ * Get the path to read for \p fname.
+ * Input files refer to MS files by their uncompressed names, so if \p fname does not exist
+ * but a compressed copy does, the compressed copy is used.
+ * @param fname Path to file.
+ * @return \p fname with GZIP_EXT appended if only the compressed file exists, otherwise \p fname.
+ */
+std::string gzip::findFile(const std::string& fname)
+{
+    if(!utils::fileExists(fname) && utils::fileExists(fname + GZIP_EXT))
+        return fname + GZIP_EXT;
+    return fname;
+}
+
+/**
+ * Read the entire contents of \p fname into memory, decompressing it if it is compressed.
+ * @param fname Path to file.
+ * @param data Contents of file.
+ * @return true if all file I/O was successful.
+ */
+bool gzip::readFile(const std::string& fname, std::string& data)
+{
+    IfStream inF(fname);
+    if(!inF) return false;
+    data.clear();
+    if(inF.isCompressed())
+        data.reserve((size_t)uncompressedSize(fname));
+
+    char buffer[65536];
+    while(inF.read(buffer, sizeof(buffer)) || inF.gcount() > 0)
+        data.append(buffer, (size_t)inF.gcount());
+    return !inF.failed() && !inF.bad();
+}
+
+gzip::StreamBuf::StreamBuf(const std::string& fname)
+{
+    _fname = fname;
+    _done = false;
+    _failed = false;
+    _stop = false;
+    _windowOffset = 0;
+    setg(nullptr, nullptr, nullptr);
+    _thread = std::thread(&StreamBuf::decompress, this);
+}
+
+gzip::StreamBuf::~StreamBuf()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        _stop = true;
+    }
+    cv.notify_all();
+    _thread.join();
+}
+
+/**
+ * Add a decompressed chunk to the queue, waiting while the queue is full.
+ * @param chunk Chunk to add. Moved from.
+ * @return false if the reader was destroyed.
+ */
+bool gzip::StreamBuf::push(std::string& chunk)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this](){ return _stop || _chunks.size() < MAX_QUEUED_CHUNKS; });
+    if(_stop) return false;
+    _chunks.push_back(std::move(chunk));
+    lock.unlock();
+    cv.notify_all();
+    return true;
+}
+
+//! Body of the decompression thread.
+void gzip::StreamBuf::decompress()
+{
+    bool success = false;
+#ifdef ENABLE_ZLIB
+    std::ifstream inF(_fname, std::ios::binary);
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    //15 + 16 only accepts gzip headers
+    if(inF && inflateInit2(&stream, 15 + 16) == Z_OK) {
+        std::vector<char> input(256 * 1024);
+        std::string chunk(CHUNK_SIZE, '\0');
+        size_t chunkSize = 0;
+        int ret = Z_OK;
+        success = true;
+        while(success) {
+            if(stream.avail_in == 0) {
+                inF.read(input.data(), (std::streamsize)input.size());
+                stream.avail_in = (uInt)inF.gcount();
+                stream.next_in = (Bytef*)input.data();
+                if(stream.avail_in == 0) {
+                    //the file ended in the middle of a member
+                    success = ret == Z_STREAM_END;
+                    break;
+                }
+            }
+            //concatenated gzip members are read as one file
+            if(ret == Z_STREAM_END && inflateReset(&stream) != Z_OK) {
+                success = false;
+                break;
+            }
+
+            stream.next_out = (Bytef*)&chunk[chunkSize];
+            stream.avail_out = (uInt)(CHUNK_SIZE - chunkSize);
+            ret = inflate(&stream, Z_NO_FLUSH);
+            if(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                success = false;
+                break;
+            }
+            chunkSize = CHUNK_SIZE - stream.avail_out;
+            if(chunkSize == CHUNK_SIZE) {
+                if(!push(chunk)) break;
+                chunk.assign(CHUNK_SIZE, '\0');
+                chunkSize = 0;
+            }
+        }
+        if(success && chunkSize > 0) {
+            chunk.resize(chunkSize);
+            push(chunk);
+        }
+        inflateEnd(&stream);
+    }
+    if(!success)
+        std::cerr << "\n\tFailed to decompress: " << _fname << NEW_LINE;
+#else
+    std::cerr << "ionFinder was built without zlib. Can not read compressed file: " << _fname << NEW_LINE;
+#endif
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        _done = true;
+        _failed = !success;
+    }
+    cv.notify_all();
+}
+
+//! Did the decompression thread stop because of an error?
+bool gzip::StreamBuf::failed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return _failed;
+}
+
+/**
+ * Replace the get area with the next decompressed chunk.
+ * The end of the current window is kept at the beginning of the new one.
+ */
+gzip::StreamBuf::int_type gzip::StreamBuf::underflow()
+{
+    if(gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+    std::string chunk;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this](){ return _done || !_chunks.empty(); });
+        if(_chunks.empty()) {
+            //a failed file ends early. Readers check failed() to tell it from the real end.
+            return traits_type::eof();
+        }
+        chunk = std::move(_chunks.front());
+        _chunks.pop_front();
+    }
+    cv.notify_all();
+
+    size_t const keep = std::min(_window.size(), SEEK_BACK_SIZE);
+    _windowOffset += _window.size() - keep;
+    _window.erase(0, _window.size() - keep);
+    _window += chunk;
+
+    char* begin = &_window[0];
+    setg(begin, begin + keep, begin + _window.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+gzip::StreamBuf::pos_type gzip::StreamBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                                   std::ios_base::openmode which)
+{
+    if(dir == std::ios_base::cur)
+        return seekpos(pos_type((off_type)(_windowOffset + (uint64_t)(gptr() - eback())) + off), which);
+    if(dir == std::ios_base::beg)
+        return seekpos(pos_type(off), which);
+    return pos_type(off_type(-1));
+}
+
+//! Seek to \p pos. Only positions in the current window are supported.
+gzip::StreamBuf::pos_type gzip::StreamBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    off_type const offset = (off_type)pos;
+    if(!(which & std::ios_base::in) || offset < (off_type)_windowOffset ||
+       offset > (off_type)(_windowOffset + _window.size()))
+        return pos_type(off_type(-1));
+    char* begin = _window.empty() ? nullptr : &_window[0];
+    setg(begin, begin + (offset - (off_type)_windowOffset), begin + _window.size());
+    return pos;
+}
+
+/**
+ * Open \p fname, decompressing it on a background thread if it is gzip compressed.
+ * If \p fname can not be opened, failbit is set.
+ * @param fname Path to file.
+ */
+gzip::IfStream::IfStream(const std::string& fname) : std::istream(nullptr)
+{
+    _compressed = gzip::isCompressed(fname);
+    if(_compressed) {
+        _buf.reset(new StreamBuf(fname));
+    }
+    else {
+        std::filebuf* buf = new std::filebuf();
+        _buf.reset(buf);
+        if(!buf->open(fname, std::ios_base::in | std::ios_base::binary)) {
+            rdbuf(_buf.get());
+            setstate(std::ios_base::failbit);
+            return;
+        }
+    }
+    rdbuf(_buf.get());
+}
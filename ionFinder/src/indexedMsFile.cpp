@@ -0,0 +1,457 @@
+//
+// indexedMsFile.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <indexedMsFile.hpp>
+
+/**
+ * Load the scan index for \p fname, building it if there is no up to date sidecar.
+ * The index is built with _nThread threads.
+ * gzip compressed files can not be read at random offsets, so they are decompressed into memory
+ * and scans are read from there.
+ * @param fname Path to MS file.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::IndexedMsFile::read(const std::string& fname)
+{
+    DecodeThreads threads(_nThread);
+    return readIndex(fname, threads);
+}
+
+/**
+ * Same as read, but the index is built with \p threads.
+ * @param fname Path to MS file.
+ * @param threads Threads to build the index with.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::IndexedMsFile::readIndex(const std::string& fname, DecodeThreads& threads)
+{
+    _fname = fname;
+    _compressed = gzip::isCompressed(fname);
+    if(_compressed) {
+        if(!gzip::readFile(fname, _data)) return false;
+        const char* begin = _data.data();
+        const char* end = begin + _data.size();
+        return _useSidecar ? _index.load(fname, begin, end, threads) : _index.build(fname, begin, end, threads);
+    }
+    return _useSidecar ? _index.load(fname, threads) : _index.build(fname, threads);
+}
+
+/**
+ * Open a stream to read scans from. Nothing is opened for compressed files.
+ * @param inF Stream to open.
+ * @return true if successful.
+ */
+bool ms2::IndexedMsFile::openFile(std::ifstream& inF) const
+{
+    if(_compressed) return true;
+    inF.open(_fname, std::ios::binary);
+    return (bool)inF;
+}
+
+/**
+ * Read the bytes of the scan at \p entry.
+ * @param inF Stream opened with openFile.
+ * @param entry Index entry of scan.
+ * @param block Set to text of scan.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::IndexedMsFile::readBlock(std::ifstream& inF, const ScanIndex::Entry& entry, std::string& block) const
+{
+    if(_compressed) {
+        if(entry.offset + entry.length > _data.size()) return false;
+        block.assign(_data, (size_t)entry.offset, (size_t)entry.length);
+        return true;
+    }
+    block.resize((size_t)entry.length);
+    inF.seekg((std::streamoff)entry.offset);
+    return (bool)inF.read(&block[0], (std::streamsize)entry.length);
+}
+
+/**
+ * Read the bytes of the scan at \p entry.
+ * A new stream is opened for each call so scans can be read from several threads at once.
+ * @param entry Index entry of scan.
+ * @param block Set to text of scan.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::IndexedMsFile::readBlock(const ScanIndex::Entry& entry, std::string& block) const
+{
+    std::ifstream inF;
+    if(!openFile(inF)) return false;
+    return readBlock(inF, entry, block);
+}
+
+void ms2::IndexedMsFile::makeIons(const std::vector<double>& mz, const std::vector<double>& intensity,
+                                  std::vector<ScanIon>& ions)
+{
+    size_t const n = std::min(mz.size(), intensity.size());
+    ions.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        ions[i].setMZ(mz[i]);
+        ions[i].setIntensity(intensity[i]);
+    }
+}
+
+/**
+ * Parse the text of a single scan from an .ms2 file.
+ * Precursor m/z, retention time and charge are not parsed because they are already in the ScanIndex.
+ * @param begin Beginning of scan.
+ * @param end End of scan.
+ * @param precursor Precursor to set intensity and scan of.
+ * @param ions Populated with the ions in the scan.
+ * @return true if successful.
+ */
+bool ms2::IndexedMsFile::parseMs2(const char* begin, const char* end, PrecursorScan& precursor, std::vector<ScanIon>& ions)
+{
+    std::vector<std::string> elems;
+    const char* line = begin;
+    while(line < end) {
+        const char* lineEnd = (const char*)std::memchr(line, '\n', (size_t)(end - line));
+        if(lineEnd == nullptr) lineEnd = end;
+
+        if(*line == 'I') {
+            utils::split(utils::trim(std::string(line, lineEnd)), '\t', elems);
+            if(elems.size() >= 3) {
+                if(elems[1] == "PrecursorInt")
+                    precursor.setIntensity(std::atof(elems[2].c_str()));
+                else if(elems[1] == "PrecursorScan")
+                    precursor.setScan(elems[2]);
+            }
+        }
+        else if(isdigit((unsigned char)*line)) {
+            //The last line of a file may not end with a newline.
+            //Copy it so strtod can not read past the end of the buffer.
+            std::string lastLine;
+            const char* peak = line;
+            if(lineEnd == end) {
+                lastLine.assign(line, lineEnd);
+                peak = lastLine.c_str();
+            }
+            char* mzEnd;
+            ScanIon ion;
+            ion.setMZ(std::strtod(peak, &mzEnd));
+            ion.setIntensity(std::strtod(mzEnd, nullptr));
+            ions.push_back(ion);
+        }
+        line = lineEnd + 1;
+    }
+    return true;
+}
+
+bool ms2::IndexedMsFile::parseMzXML(const std::string& block, PrecursorScan& precursor, std::vector<ScanIon>& ions)
+{
+    std::string value;
+
+    //precursor
+    size_t tagBegin = block.find("<precursorMz");
+    if(tagBegin != std::string::npos) {
+        size_t tagEnd = block.find('>', tagBegin);
+        if(getXmlAttribute(block, tagBegin, tagEnd, "precursorIntensity", value))
+            precursor.setIntensity(std::atof(value.c_str()));
+        if(getXmlAttribute(block, tagBegin, tagEnd, "precursorScanNum", value))
+            precursor.setScan(value);
+    }
+
+    //peaks
+    tagBegin = block.find("<peaks");
+    if(tagBegin == std::string::npos) return true;
+    size_t tagEnd = block.find('>', tagBegin);
+    size_t dataEnd = block.find("</peaks>", tagEnd);
+    if(tagEnd == std::string::npos || dataEnd == std::string::npos) return false;
+
+    int precision = 32;
+    if(getXmlAttribute(block, tagBegin, tagEnd, "precision", value))
+        precision = std::atoi(value.c_str());
+    bool zlib = getXmlAttribute(block, tagBegin, tagEnd, "compressionType", value) && value == "zlib";
+    ByteOrder byteOrder = ByteOrder::BIG_ENDIAN_ORDER;
+    if(getXmlAttribute(block, tagBegin, tagEnd, "byteOrder", value) && value != "network")
+        byteOrder = ByteOrder::LITTLE_ENDIAN_ORDER;
+    size_t peaksCount = 0;
+    if(getXmlAttribute(block, 0, block.find('>'), "peaksCount", value))
+        peaksCount = (size_t)std::atol(value.c_str());
+
+    //m/z and intensity pairs are interleaved
+    std::vector<double> values;
+    if(!decodeBinaryArray(block.c_str() + tagEnd + 1, block.c_str() + dataEnd,
+                          precision, byteOrder, zlib, values, peaksCount * 2))
+        return false;
+    size_t const n = values.size() / 2;
+    ions.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        ions[i].setMZ(values[i * 2]);
+        ions[i].setIntensity(values[i * 2 + 1]);
+    }
+    return true;
+}
+
+bool ms2::IndexedMsFile::parseMzML(const std::string& block, PrecursorScan& precursor, std::vector<ScanIon>& ions)
+{
+    std::string value;
+
+    //precursor
+    size_t precursorBegin = block.find("<precursor ");
+    if(precursorBegin != std::string::npos) {
+        size_t precursorEnd = block.find("</precursor>", precursorBegin);
+        if(getXmlAttribute(block, precursorBegin, block.find('>', precursorBegin), "spectrumRef", value))
+            precursor.setScan(std::to_string(scanNumFromNativeId(value)));
+        if(getCvParam(block, precursorBegin, precursorEnd, "MS:1000042", value))
+            precursor.setIntensity(std::atof(value.c_str()));
+    }
+
+    //binary data arrays
+    size_t arrayLength = 0;
+    if(getXmlAttribute(block, 0, block.find('>'), "defaultArrayLength", value))
+        arrayLength = (size_t)std::atol(value.c_str());
+    std::vector<double> mz, intensity;
+    size_t arrayBegin = 0;
+    while((arrayBegin = block.find("<binaryDataArray ", arrayBegin)) != std::string::npos) {
+        size_t arrayEnd = block.find("</binaryDataArray>", arrayBegin);
+        if(arrayEnd == std::string::npos) return false;
+
+        std::vector<double>* dest = nullptr;
+        if(hasCvParam(block, arrayBegin, arrayEnd, "MS:1000514")) dest = &mz;
+        else if(hasCvParam(block, arrayBegin, arrayEnd, "MS:1000515")) dest = &intensity;
+
+        if(dest) {
+            int precision = hasCvParam(block, arrayBegin, arrayEnd, "MS:1000523") ? 64 : 32;
+            bool zlib = hasCvParam(block, arrayBegin, arrayEnd, "MS:1000574");
+            size_t dataBegin = block.find("<binary>", arrayBegin);
+            size_t dataEnd = block.find("</binary>", arrayBegin);
+            if(dataBegin == std::string::npos || dataEnd == std::string::npos || dataEnd > arrayEnd)
+                return false;
+            if(!decodeBinaryArray(block.c_str() + dataBegin + 8, block.c_str() + dataEnd,
+                                  precision, ByteOrder::LITTLE_ENDIAN_ORDER, zlib, *dest, arrayLength))
+                return false;
+        }
+        arrayBegin = arrayEnd;
+    }
+    makeIons(mz, intensity, ions);
+    return true;
+}
+
+/**
+ * Only the index and the requested scans are held in memory, which is not known until the index is read.
+ * Compressed files are decompressed into memory, so their decompressed size is used.
+ * @return Decompressed size of compressed files, otherwise 0.
+ */
+size_t ms2::IndexedMsFile::estimateMemory(const std::string& fname) const
+{
+    return gzip::isCompressed(fname) ? (size_t)gzip::uncompressedSize(fname) : 0;
+}
+
+//! Approximate bytes used by the index, decoded scans and decompressed file.
+size_t ms2::IndexedMsFile::memoryUsage() const
+{
+    size_t ret = _index.memoryUsage() + _data.capacity();
+    for(const auto& scan : _decoded)
+        ret += sizeof(DecodedScan) + scan.second.ions.capacity() * sizeof(ScanIon);
+    return ret;
+}
+
+/**
+ * Parse the text of a scan read from the file.
+ * @param entry Index entry of scan.
+ * @param block Text of scan.
+ * @param precursor Populated with precursor data.
+ * @param ions Populated with the ions in the scan.
+ * @return true if successful.
+ */
+bool ms2::IndexedMsFile::parseScan(const ScanIndex::Entry& entry, const std::string& block,
+                                   PrecursorScan& precursor, std::vector<ScanIon>& ions) const
+{
+    precursor.setFile(_fname);
+    precursor.setMZ(entry.precursorMZ);
+    precursor.setRT(entry.rt);
+    precursor.setCharge(entry.charge);
+
+    switch(_index.getFileType()) {
+        case ScanIndex::FileType::MS2: return parseMs2(block.data(), block.data() + block.size(), precursor, ions);
+        case ScanIndex::FileType::MZXML: return parseMzXML(block, precursor, ions);
+        case ScanIndex::FileType::MZML: return parseMzML(block, precursor, ions);
+        default: return false;
+    }
+}
+
+/**
+ * Load the scan index for \p fname and decode only the scans in \p scans.
+ * Scans are read in the order they appear in the file so the file is read in one forward pass.
+ * Every DECODE_CHUNK_BYTES of scan text read is parsed and decoded by up to _nThread threads,
+ * with each thread writing to its own scans. The calling thread reads the next chunk while
+ * the other threads decode the current one. Extra threads are taken from the DecodeThreads limit
+ * once for the whole file and are reused for every chunk.
+ * The peaks of all other scans are never read or decoded.
+ * Scans in \p scans which are not in the file are ignored here and reported by getScan.
+ * @param fname Path to MS file.
+ * @param scans Sorted list of scan numbers which will be requested.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::IndexedMsFile::read(const std::string& fname, const std::vector<size_t>& scans)
+{
+    DecodeThreads decodeThreads(_nThread);
+    if(!readIndex(fname, decodeThreads)) return false;
+
+    std::vector<const ScanIndex::Entry*> entries;
+    entries.reserve(scans.size());
+    for(size_t scanNum : scans) {
+        const ScanIndex::Entry* entry = _index.find(scanNum);
+        if(entry) entries.push_back(entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const ScanIndex::Entry* lhs, const ScanIndex::Entry* rhs){
+        return lhs->offset < rhs->offset;
+    });
+    //scans requested more than once must only be decoded by one thread
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    //Map nodes are created here so the decode threads only write to existing scans.
+    std::vector<DecodedScan*> decoded(entries.size());
+    for(size_t i = 0; i < entries.size(); i++)
+        decoded[i] = &_decoded[entries[i]->scanNum];
+    std::vector<char> failed(entries.size(), 0);
+
+    std::ifstream inF;
+    if(!openFile(inF)) return false;
+    //read the scans from chunkBegin into blocks, stopping once DECODE_CHUNK_BYTES have been read
+    auto readChunk = [&](size_t chunkBegin, std::vector<std::string>& blocks, size_t& chunkEnd) -> bool {
+        chunkEnd = chunkBegin;
+        size_t chunkBytes = 0;
+        blocks.clear();
+        while(chunkEnd < entries.size() && (chunkBytes < DECODE_CHUNK_BYTES || chunkEnd == chunkBegin)) {
+            const ScanIndex::Entry* entry = entries[chunkEnd++];
+            blocks.emplace_back();
+            if(!readBlock(inF, *entry, blocks.back()))
+                return false;
+            chunkBytes += (size_t)entry->length;
+        }
+        return true;
+    };
+
+    std::vector<std::string> blocks, nextBlocks;
+    size_t chunkBegin = 0;
+    size_t chunkEnd = 0;
+    if(!readChunk(chunkBegin, blocks, chunkEnd)) return false;
+    while(chunkBegin < entries.size()) {
+        //decode the current chunk while the next one is read
+        decodeThreads.start(chunkEnd - chunkBegin, [&, chunkBegin](size_t j){
+            size_t const i = chunkBegin + j;
+            failed[i] = !parseScan(*entries[i], blocks[j], decoded[i]->precursor, decoded[i]->ions);
+            //filtered peaks are not kept in memory
+            if(!failed[i] && _peakFilter.active()) {
+                _peakFilter.apply(decoded[i]->ions);
+                decoded[i]->ions.shrink_to_fit();
+            }
+        });
+        size_t nextEnd = chunkEnd;
+        bool readOk = true;
+        if(decodeThreads.size() > 1)
+            readOk = readChunk(chunkEnd, nextBlocks, nextEnd);
+        decodeThreads.wait();
+        //with no extra threads the chunk is decoded by wait, so the next chunk is read after it
+        if(decodeThreads.size() == 1)
+            readOk = readChunk(chunkEnd, nextBlocks, nextEnd);
+        if(!readOk) return false;
+
+        blocks.swap(nextBlocks);
+        chunkBegin = chunkEnd;
+        chunkEnd = nextEnd;
+    }
+
+    for(size_t i = 0; i < entries.size(); i++) {
+        if(failed[i]) {
+            std::cerr << "\n\tFailed to parse scan " << entries[i]->scanNum << " in " << _fname << NEW_LINE;
+            _decoded.erase(entries[i]->scanNum);
+        }
+    }
+    return true;
+}
+
+/**
+ * Get a single scan. Scans decoded in read are copied from memory,
+ * all others are read and parsed from the file.
+ * This function is thread safe.
+ * @param scanNum Scan number to retrieve.
+ * @param scan Spectrum to populate.
+ * @return true if the scan was found and successfully parsed.
+ */
+bool ms2::IndexedMsFile::getScan(size_t scanNum, ms2::Spectrum& scan) const
+{
+    PrecursorScan precursor;
+    std::vector<ScanIon> ions;
+
+    auto it = _decoded.find(scanNum);
+    if(it != _decoded.end()) {
+        precursor = it->second.precursor;
+        ions = it->second.ions;
+    }
+    else {
+        const ScanIndex::Entry* entry = _index.find(scanNum);
+        if(!entry) return false;
+
+        std::string block;
+        if(!readBlock(*entry, block)) return false;
+        if(!parseScan(*entry, block, precursor, ions)) return false;
+        _peakFilter.apply(ions);
+    }
+
+    scan.assign(scanNum, precursor, ions);
+    return true;
+}
+
+/**
+ * Parse every scan in the file in the order they appear in the file.
+ * read must be called first. The peak filter is not applied, so every peak is passed to \p callback.
+ * @param callback Called with the index entry, precursor and ions of each scan.
+ * @return true if all scans were read and parsed and \p callback never returned false.
+ */
+bool ms2::IndexedMsFile::forEachScan(const ScanCallback& callback) const
+{
+    std::vector<const ScanIndex::Entry*> entries;
+    entries.reserve(_index.size());
+    for(const auto& entry : _index.getEntries())
+        entries.push_back(&entry);
+    std::sort(entries.begin(), entries.end(), [](const ScanIndex::Entry* lhs, const ScanIndex::Entry* rhs){
+        return lhs->offset < rhs->offset;
+    });
+
+    std::ifstream inF;
+    if(!openFile(inF)) return false;
+    std::string block;
+    PrecursorScan precursor;
+    std::vector<ScanIon> ions;
+    for(const ScanIndex::Entry* entry : entries) {
+        if(!readBlock(inF, *entry, block))
+            return false;
+
+        precursor = PrecursorScan();
+        ions.clear();
+        if(!parseScan(*entry, block, precursor, ions)) {
+            std::cerr << "\n\tFailed to parse scan " << entry->scanNum << " in " << _fname << NEW_LINE;
+            return false;
+        }
+        if(!callback(*entry, precursor, ions)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+//
+// aaDBCache.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <ionFinder/aaDBCache.hpp>
+#include <ionFinder/datProc.hpp>
+
+/**
+ * Get the cache key for the sample \p scan belongs to.
+ * \param scan Scan to get key for.
+ * \return Directory of the MS file for \p scan in DTAFilter input mode, otherwise an empty string.
+ */
+std::string IonFinder::AADBCache::getKey(const Dtafilter::Scan& scan) const
+{
+    if(_pars.getInputMode() == DTAFILTER_INPUT_STR)
+        return utils::dirName(scan.getPrecursor().getFile());
+    return "";
+}
+
+/**
+ * Read amino acid masses for every sample in \p scans.
+ * Samples are read in parallel on the workers in \p pool.
+ * \param scans Scans to read masses for.
+ * \param pool Thread pool to read on.
+ * \throws std::runtime_error if a sequest.params file could not be read.
+ */
+void IonFinder::AADBCache::build(const std::vector<Dtafilter::Scan>& scans, ThreadPool& pool)
+{
+    // one representative scan for each directory which has not been read yet
+    std::vector<const Dtafilter::Scan*> needed;
+    std::set<std::string> keys;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const auto& scan : scans){
+            std::string key = getKey(scan);
+            if(_masses.find(key) == _masses.end() && keys.insert(key).second)
+                needed.push_back(&scan);
+        }
+    }
+
+    std::vector<aaDB::AADB> built(needed.size());
+    pool.parallelFor(0, needed.size(), 1, [&](size_t beg, size_t end){
+        for(size_t i = beg; i < end; i++)
+            IonFinder::initAminoAcidMasses(*needed[i], _pars, built[i]);
+    });
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for(size_t i = 0; i < needed.size(); i++)
+        _masses.emplace(getKey(*needed[i]), built[i]);
+}
+
+/**
+ * Get amino acid masses for the sample \p scan belongs to.
+ * If the sample was not read by build() it is read now.
+ * \param scan Scan to get masses for.
+ * \return Masses for sample.
+ * \throws std::runtime_error if a sequest.params file could not be read.
+ */
+const aaDB::AADB& IonFinder::AADBCache::get(const Dtafilter::Scan& scan)
+{
+    std::string key = getKey(scan);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = _masses.find(key);
+        if(it != _masses.end()) return it->second;
+    }
+
+    // read outside the lock so other samples can still be looked up
+    aaDB::AADB masses;
+    IonFinder::initAminoAcidMasses(scan, _pars, masses);
+
+    // if another thread read the same sample first its entry is kept
+    std::lock_guard<std::mutex> lock(mutex);
+    return _masses.emplace(key, masses).first->second;
+}
@@ -0,0 +1,117 @@
+//
+// cacheCommand.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <ionFinder/cacheCommand.hpp>
+
+/**
+ Check whether the program was invoked as <tt>ionFinder cache ...</tt>
+ \param argc Number of command line arguments.
+ \param argv Command line arguments.
+ \return true if the first argument is the cache subcommand.
+ */
+bool IonFinder::isCacheCommand(int argc, const char* const argv[])
+{
+    return argc > 1 && argv[1] == CACHE_COMMAND;
+}
+
+static void cacheUsage(const char* progName, std::ostream& out = std::cerr)
+{
+    out << "usage: " << progName << " " << IonFinder::CACHE_COMMAND
+        << " [-p <number_of_threads>] [-f] <ms_file> [...]" << NEW_LINE;
+}
+
+/**
+ Write a binary cache next to each MS file given on the command line. <br>
+ Caches which are already up to date are skipped unless -f is given.
+ \param argc Number of command line arguments.
+ \param argv Command line arguments. argv[1] is the subcommand name.
+ \return Exit code for main.
+ */
+int IonFinder::runCacheCommand(int argc, const char* const argv[])
+{
+    unsigned int nThread = std::max(1u, std::thread::hardware_concurrency());
+    bool force = false;
+    std::vector<std::string> files;
+
+    for(int i = 2; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")){
+            cacheUsage(argv[0], std::cout);
+            return 0;
+        }
+        if(!strcmp(argv[i], "-f")){
+            force = true;
+            continue;
+        }
+        if(!strcmp(argv[i], "-p") || !strcmp(argv[i], "--nThread"))
+        {
+            if(++i >= argc || !utils::isArg(argv[i]) || std::stoi(argv[i]) < 1){
+                cacheUsage(argv[0]);
+                return 1;
+            }
+            nThread = std::stoi(argv[i]);
+            continue;
+        }
+        if(!utils::isArg(argv[i])){
+            std::cerr << argv[i] << " is an invalid argument." << NEW_LINE;
+            cacheUsage(argv[0]);
+            return 1;
+        }
+        files.push_back(argv[i]);
+    }
+    if(files.empty()){
+        cacheUsage(argv[0]);
+        return 1;
+    }
+
+    std::atomic<size_t> nWritten(0);
+    std::atomic<size_t> nSkipped(0);
+    std::atomic<size_t> nFailed(0);
+    IonFinder::ThreadPool pool(nThread);
+    //files are written in parallel, so their decode threads share one limit
+    ms2::DecodeThreads::setLimit(nThread);
+    pool.parallelFor(0, files.size(), 1, [&](size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++){
+            if(!force && ms2::BinaryCacheFile::isCurrent(files[i])){
+                nSkipped++;
+                continue;
+            }
+            if(ms2::ScanIndex::getFileType(files[i]) == ms2::ScanIndex::FileType::UNKNOWN ||
+               !ms2::BinaryCacheFile::write(files[i], ms2::BinaryCacheFile::cacheName(files[i]))){
+                std::cerr << "Failed to write cache for: " << files[i] << NEW_LINE;
+                nFailed++;
+            }
+            else nWritten++;
+        }
+    });
+
+    std::cout << "Wrote caches for " << nWritten.load() << " of " << files.size() << " files.";
+    if(nSkipped.load() > 0)
+        std::cout << " Skipped " << nSkipped.load() << " files with up to date caches.";
+    std::cout << NEW_LINE;
+    return nFailed.load() == 0 ? 0 : 1;
+}
@@ -37,11 +37,12 @@ IonFinder::PeptideStats::PeptideStats(const IonFinder::PeptideStats& rhs) {
     modLocs = rhs.modLocs;
     modIndex = rhs.modIndex;
     modResidues = rhs.modResidues;
+    residueMods = rhs.residueMods;
+    nlMass = rhs.nlMass;
     _id = rhs._id;
     charge = rhs.charge;
     fullSequence = rhs.fullSequence;
     mass = rhs.mass;
-    _scan = new Dtafilter::Scan;
     _scan = rhs._scan;
 }
 
@@ -156,7 +157,7 @@ double IonFinder::PeptideStats::totalFragmentIntensity(double min, double max) c
 
 /**
  Add fragment sequence to PeptideStats.
- \pre \p seq._sequence is in *this->sequence
+ \pre The sequence of \p seq is in *this->sequence
  \param seq fragment ion to add
  \param modLoc Location of modification to add for.
  \param ambResidues ambiguous residues to search for.
@@ -168,7 +169,7 @@ void IonFinder::PeptideStats::addSeq(const PeptideNamespace::FragmentIon& seq,
 	assert(utils::strContains(seq.getSequence(), sequence));
 	
 	//increment total fragment ions found
-	IonFinder::FragmentIon ionStr = IonFinder::FragmentIon(seq.getLabel(true), seq.getFoundIntensity());
+	IonFinder::FragmentIon ionStr(seq);
 	ionTypesCount[IonType::FRAG].insert(ionStr);
 	
     //check if in span
@@ -206,6 +207,20 @@ void IonFinder::PeptideStats::addSeq(const PeptideNamespace::FragmentIon& seq,
     }//end of else
 }//end of fxn
 
+/**
+ Make label for \p ion.
+ \param ion Fragment ion added to *this by addSeq.
+ \return Label of \p ion with modifications.
+ */
+std::string IonFinder::PeptideStats::getIonStr(const IonFinder::FragmentIon& ion) const
+{
+	std::string mod;
+	for(size_t i = ion.getBegin(); i <= ion.getEnd() && i < residueMods.size(); i++)
+		if(residueMods[i] != '\0')
+			mod += residueMods[i];
+	return PeptideNamespace::makeIonLabel(ion.getKey(), mod, nlMass);
+}
+
 /**
  * Remove all ions from ionTypesCount below \p intensity.
  * \param intensity
@@ -279,17 +294,21 @@ double IonFinder::PeptideStats::calcIntCO(double fractionArtifact) const
 
 /**
  * Analyze the fragment ions found in the context of the peptide sequence to determine
- * whether the peptide is likely to be modified.
+ * whether the peptide is likely to be modified. <br>
+ * Peptides are split into contiguous chunks which are analyzed concurrently on \p pool.
+ * Results for each chunk are concatenated so \p peptideStats is in the same order regardless of the number of threads.
  *
  * \param scans Populated vector of scans.
  * \param peptides Populated vector of peptides.
  * \param peptideStats Empty vector of peptideStats.
  * \param pars Populated Params object.
+ * \param pool Thread pool to run analysis on.
  */
 bool IonFinder::analyzeSequences(std::vector<Dtafilter::Scan>& scans,
 								 const std::vector<PeptideNamespace::Peptide>& peptides,
 								 std::vector<PeptideStats>& peptideStats,
-								 const IonFinder::Params& pars)
+								 const IonFinder::Params& pars,
+								 ThreadPool& pool)
 {
 	bool allSucess = true;
 	bool addModResidues = !pars.getFastaFile().empty();
@@ -301,77 +320,39 @@ bool IonFinder::analyzeSequences(std::vector<Dtafilter::Scan>& scans,
 		std::cout << "Done!" << NEW_LINE;
 	}
 
-	for(auto it = peptides.begin(); it != peptides.end(); ++it)
-	{
-		std::vector<IonFinder::PeptideStats> this_stats;
-
-		std::vector<size_t> modLocsTemp;
-		if(it->isModified())
-			modLocsTemp = it->getModLocs();
-		else modLocsTemp.push_back(std::string::npos);
-
-        for(auto mod_it = modLocsTemp.begin(); mod_it != modLocsTemp.end(); ++mod_it)
-		{
-            // initialize new pepStat object
-            this_stats.emplace_back(*it);
-            // this_stats.push_back(IonFinder::PeptideStats(
-            this_stats.back()._scan = &scans[it - peptides.begin()]; //add pointer to scan
-            size_t nFragments = it->getNumFragments();
-            this_stats.back().modIndex = *mod_it;
-
-            // iterate through ion fragments
-            for (size_t i = 0; i < nFragments; i++) {
-                //skip if not found
-                if (it->getFragment(i).getFound()) {
-                    this_stats.back().addSeq(it->getFragment(i), *mod_it, pars.getAmbigiousResidues());
-                } //end of if
-            }//end of for i
-
-            // if(it->getFullSequence() == "LEYQWTNNIGDAHTIGTR*PDNGMLSLGVSYR")
-            // if(this_stats.back()._scan->getScanNum() == 23248)
-            //     std::cout << "Found" << std::endl;
-
-            // Filter to remove Artifact ions
-            double int_co = this_stats.back().calcIntCO(pars.getArtifactNLIntFrac());
-            this_stats.back().removeBelowIntensity(int_co);
-
-            this_stats.back().calcContainsCit(pars.getIncludeCTermMod());
-
-            if(addModResidues && *mod_it != std::string::npos) {
-                bool found; //set to true if peptide and protein sequences are found in FastaFile
-                std::string modTemp = seqFile.getModifiedResidue(this_stats.back()._scan->getParentID(),
-                                                                 this_stats.back().sequence, int(*mod_it),
-                                                                 pars.getVerbose(), found);
-                this_stats.back().addMod(modTemp);
-                if (!found)
-                    nSeqNotFound++;
-            }
-        }//end for mod_it
-
-        assert(pars.getGroupMod() == 0 || pars.getGroupMod() == 1);
-        if(pars.getGroupMod() == 0)
-        {
-            PeptideStats::ContainsCitType cc = PeptideStats::ContainsCitType::TRUE;
-            for (const auto &s:this_stats) {
-                cc = std::min(cc, s.thisContainsCit);
-            }
-
-            for(auto & this_stat : this_stats) {
-                this_stat.containsCit = cc;
-                peptideStats.push_back(this_stat);
-            }
-        }
-        else {
-            for(auto s = this_stats.begin(); s != this_stats.end(); ++s){
-                if(s == this_stats.begin()) {
-                    peptideStats.push_back(*s);
-                    peptideStats.back().containsCit = s->thisContainsCit;
-                }
-                else peptideStats.back().consolidate(*s);
-            }
-        }
-		
-	}//end if for it
+	size_t const nPeptides = peptides.size();
+	size_t const chunkSize = std::max<size_t>(1, nPeptides / ((pool.size() + 1) * CHUNKS_PER_THREAD));
+	size_t const nChunks = (nPeptides + chunkSize - 1) / chunkSize;
+	std::vector<std::vector<PeptideStats> > chunkStats(nChunks);
+	std::vector<int> chunkNotFound(nChunks, 0);
+
+	//one counter for each pool worker and one for the calling thread
+	ProgressReporter progress("\nAnalyzing peptide sequences...", nPeptides, pool.size() + 1, !pars.getVerbose());
+	progress.start();
+	pool.parallelFor(0, nPeptides, chunkSize, [&](size_t beg, size_t end){
+		size_t chunk = beg / chunkSize;
+		chunkStats[chunk].reserve(end - beg);
+		ProgressCounter& counter = progress.getCounter(pool.workerIndex());
+		for(size_t i = beg; i < end; i++){
+			IonFinder::analyzePeptide(scans[i], peptides[i], addModResidues ? &seqFile : nullptr,
+									  pars, chunkStats[chunk], chunkNotFound[chunk]);
+			++counter;
+		}
+	});
+	progress.finish();
+
+	//concatenate chunks in order. Each chunk is discarded after it is added, so its stats are moved.
+	size_t nStats = 0;
+	for(const auto& chunk : chunkStats)
+		nStats += chunk.size();
+	peptideStats.reserve(peptideStats.size() + nStats);
+	for(size_t i = 0; i < nChunks; i++){
+		peptideStats.insert(peptideStats.end(),
+							std::make_move_iterator(chunkStats[i].begin()),
+							std::make_move_iterator(chunkStats[i].end()));
+		std::vector<PeptideStats>().swap(chunkStats[i]);
+		nSeqNotFound += chunkNotFound[i];
+	}
 	if(nSeqNotFound > 0){
 		std::cerr << NEW_LINE << nSeqNotFound << " protein sequences not found in " <<
 		pars.getFastaFile() << NEW_LINE;
@@ -380,6 +361,90 @@ bool IonFinder::analyzeSequences(std::vector<Dtafilter::Scan>& scans,
 	return allSucess;
 }//end of fxn
 
+/**
+ * Analyze the fragment ions found for a single peptide. <br>
+ * PeptideStats for \p peptide are appended to \p peptideStats.
+ * Depending on Params::getGroupMod there is either one PeptideStats for each modification
+ * or one for the whole peptide.
+ *
+ * \param scan Scan \p peptide was identified from.
+ * \param peptide Peptide with labeled fragments.
+ * \param seqFile FASTA file to look up modified residues in. If nullptr, modified residues are not added.
+ * \param pars Populated Params object.
+ * \param peptideStats Vector to append to.
+ * \param nSeqNotFound Incremented for each protein sequence not found in \p seqFile.
+ */
+void IonFinder::analyzePeptide(Dtafilter::Scan& scan,
+							   const PeptideNamespace::Peptide& peptide,
+							   const utils::FastaFile* seqFile,
+							   const IonFinder::Params& pars,
+							   std::vector<PeptideStats>& peptideStats,
+							   int& nSeqNotFound)
+{
+	std::vector<IonFinder::PeptideStats> this_stats;
+
+	std::vector<size_t> modLocsTemp;
+	if(peptide.isModified())
+		modLocsTemp = peptide.getModLocs();
+	else modLocsTemp.push_back(std::string::npos);
+
+	for(auto mod_it = modLocsTemp.begin(); mod_it != modLocsTemp.end(); ++mod_it)
+	{
+		// initialize new pepStat object
+		this_stats.emplace_back(peptide);
+		this_stats.back()._scan = &scan; //add pointer to scan
+		size_t nFragments = peptide.getNumFragments();
+		this_stats.back().modIndex = *mod_it;
+
+		// iterate through ion fragments
+		for (size_t i = 0; i < nFragments; i++) {
+			//skip if not found
+			if (peptide.getFragment(i).getFound()) {
+				this_stats.back().addSeq(peptide.getFragment(i), *mod_it, pars.getAmbigiousResidues());
+			} //end of if
+		}//end of for i
+
+		// Filter to remove Artifact ions
+		double int_co = this_stats.back().calcIntCO(pars.getArtifactNLIntFrac());
+		this_stats.back().removeBelowIntensity(int_co);
+
+		this_stats.back().calcContainsCit(pars.getIncludeCTermMod());
+
+		if(seqFile != nullptr && *mod_it != std::string::npos) {
+			bool found; //set to true if peptide and protein sequences are found in FastaFile
+			std::string modTemp = seqFile->getModifiedResidue(this_stats.back()._scan->getParentID(),
+															  this_stats.back().sequence, int(*mod_it),
+															  pars.getVerbose(), found);
+			this_stats.back().addMod(modTemp);
+			if (!found)
+				nSeqNotFound++;
+		}
+	}//end for mod_it
+
+	assert(pars.getGroupMod() == 0 || pars.getGroupMod() == 1);
+	if(pars.getGroupMod() == 0)
+	{
+		PeptideStats::ContainsCitType cc = PeptideStats::ContainsCitType::TRUE;
+		for (const auto &s:this_stats) {
+			cc = std::min(cc, s.thisContainsCit);
+		}
+
+		for(auto & this_stat : this_stats) {
+			this_stat.containsCit = cc;
+			peptideStats.push_back(this_stat);
+		}
+	}
+	else {
+		for(auto s = this_stats.begin(); s != this_stats.end(); ++s){
+			if(s == this_stats.begin()) {
+				peptideStats.push_back(*s);
+				peptideStats.back().containsCit = s->thisContainsCit;
+			}
+			else peptideStats.back().consolidate(*s);
+		}
+	}
+}
+
 /**
  * Print total intensities for each fragment to \p fname. (Mainly for debugging)
  * \param stats Populated list of PeptideStats.
@@ -408,118 +473,226 @@ bool IonFinder::printFragmentIntensities(const std::vector<PeptideStats>& stats,
 
 /**
  Search parent ms2 files in \p scans for predicted fragment ions. <br><br>
- Analysis is performed in parallel in number of threads in Params::_numThread. <br>
- \p scans is split up evenly across each thread.
+ Analysis is performed in parallel on the workers in \p pool. <br>
+ \p scans is split up into small batches which are scheduled across threads by a
+ IonFinder::ScanScheduler. Idle threads steal batches from busy threads so that one slow
+ region of the input does not leave other threads idle.
+ Peptides are returned in the same order as \p scans regardless of the number of threads.
  
  \param scans populated list of identified ms2 scans to search for
  \param peptides empty list of peptides to annotate
  \param pars Params object for information on how to perform analysis
+ \param pool Thread pool to run search on.
  \return true is all file I/O was successful.
  */
 bool IonFinder::findFragmentsParallel(std::vector<Dtafilter::Scan>& scans,
 									  std::vector<PeptideNamespace::Peptide>& peptides,
-									  const IonFinder::Params& pars)
+									  const IonFinder::Params& pars,
+									  ThreadPool& pool)
 {
-	unsigned int const nThread = pars.getNumThreads();
 	size_t const nScans = scans.size();
-	size_t peptidePerThread = nScans / nThread;
-	if(nScans % nThread != 0)
-		peptidePerThread += 1;
-	std::atomic<size_t> scansIndex(0); //used to update progress for findFragmentsProgress
 	
 	if(nScans == 0){
 		std::cout << "No scans in input!\n";
 		return false;
 	}
-	
-	//init threads
-	std::vector<std::thread> threads;
-	bool* sucsses = new bool[nThread];
 
-    // read ms files
-    ms2::MsInterface msInterface;
-    // msInterface.read(scans.begin(), scans.end());
-
-	//split up input data for each thread
-	auto* splitPeptides = new std::vector<PeptideNamespace::Peptide>[nThread];
-	size_t begNum, endNum ;
-	unsigned int threadIndex = 0;
-	for(size_t i = 0; i < nScans; i += peptidePerThread)
-	{
-		begNum = i;
-		endNum = (begNum + peptidePerThread > nScans ? nScans : begNum + peptidePerThread);
-
-		//spawn thread
-		assert(threadIndex < nThread);
-		splitPeptides[threadIndex] = std::vector<PeptideNamespace::Peptide>();
-		// threads.emplace_back(IonFinder::findFragments_, std::ref(scans), begNum, endNum,
-		//						  std::ref(splitPeptides[threadIndex]), std::ref(pars),
-		//						  sucsses + threadIndex, std::ref(scansIndex));
-		threads.emplace_back(IonFinder::findFragments_threadSafe, std::ref(scans), begNum, endNum,
-									  std::ref(msInterface),
-									  std::ref(splitPeptides[threadIndex]), std::ref(pars),
-									  sucsses + threadIndex, std::ref(scansIndex));
-		threadIndex++;
+	//don't use more threads than there are scans
+	unsigned int const nThread = (unsigned int)std::min<size_t>(pool.size(), nScans);
+	std::unique_ptr<ScanScheduler> scheduler;
+	if(pars.getFileAffinity()){
+		std::vector<std::string> scanFiles;
+		scanFiles.reserve(nScans);
+		for(const auto& scan : scans)
+			scanFiles.push_back(scan.getPrecursor().getFile());
+		scheduler = std::unique_ptr<ScanScheduler>(new ScanScheduler(scanFiles, nThread));
+	}
+	else scheduler = std::unique_ptr<ScanScheduler>(new ScanScheduler(nScans, nThread));
+
+	//read amino acid masses for each sample once before starting workers
+	AADBCache aadbCache(pars);
+	try{
+		aadbCache.build(scans, pool);
+	} catch(std::runtime_error& e){
+		std::cerr << e.what() << NEW_LINE;
+		return false;
 	}
 
-	//spawn progress function
-    std::string progress_messge = "\nSearching ms2s for fragment ions using " + std::to_string(nThread) + " thread(s)...";
-	if(!pars.getVerbose())
-		threads.emplace_back(IonFinder::findFragmentsProgress, std::ref(scansIndex), nScans,
-									  std::ref(progress_messge), PROGRESS_SLEEP_TIME);
+	//init workers
+	std::vector<std::future<void> > workers;
+	std::unique_ptr<bool[]> sucsses(new bool[nThread]);
+	std::vector<WorkerStats> workerStats(nThread);
+
+	// read ms files on background threads in the order workers are expected to need them
+	ms2::MsInterface msInterface(pars.getReaderOptions());
+	msInterface.addNeededScans(scans.begin(), scans.end());
+	std::vector<std::string> fileOrder;
+	fileOrder.reserve(nScans);
+	for(auto b : scheduler->projectedOrder())
+		for(auto i : scheduler->getBatch(b).indices)
+			fileOrder.push_back(scans[i].getPrecursor().getFile());
+	Prefetcher prefetcher(msInterface, fileOrder, pars.getPrefetchDepth());
+	prefetcher.start(pars.getNumIoThreads());
+
+	//fragment ladders are shared by PSMs of the same peptide across all workers
+	PeptideNamespace::LadderCache ladderCache(pars.getLadderCacheSize());
+
+	//each batch gets its own output vector so peptides can be put back in input order
+	std::vector<std::vector<PeptideNamespace::Peptide> > batchPeptides(scheduler->getNumBatches());
+
+	ProgressReporter progress("\nSearching ms2s for fragment ions using " + std::to_string(nThread) + " thread(s)...",
+							  nScans, nThread, !pars.getVerbose());
+	progress.start();
+
+	auto startTime = std::chrono::steady_clock::now();
+	for(unsigned int i = 0; i < nThread; i++){
+		workers.push_back(pool.submit(std::bind(IonFinder::findFragmentsWorker, std::ref(scans),
+												std::ref(*scheduler), i, std::ref(msInterface), std::ref(prefetcher),
+												std::ref(ladderCache), std::ref(aadbCache),
+												std::ref(batchPeptides), std::ref(pars),
+												sucsses.get() + i, std::ref(progress.getCounter(i)), std::ref(workerStats[i]))));
+	}
 
-	//join threads
-	for(auto & thread : threads){
-		thread.join();
-	 }
+	//wait for every worker before rethrowing, they all hold references to locals in this frame
+	for(auto & worker : workers){
+		worker.wait();
+	}
+	for(auto & worker : workers){
+		worker.get();
+	}
+	double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	progress.finish();
+	prefetcher.stop();
 
-	//concat split peptides into one vector
-	peptides.clear();
-	for(unsigned int i = 0; i < nThread; i++){
-		if(!sucsses[i])
-			return false;
-		peptides.insert(peptides.end(), splitPeptides[i].begin(), splitPeptides[i].end());
+	bool allSucess = true;
+	for(unsigned int i = 0; i < nThread; i++)
+		if(!sucsses[i]) allSucess = false;
+	if(!allSucess) return false;
+
+	printWorkerStats(workerStats, wallTime, pars.getVerbose());
+	if(pars.getVerbose())
+		std::cout << "MS files read in background: " << prefetcher.getNumRead() << NEW_LINE;
+
+	//put batch peptides back in the same order as scans
+	std::vector<PeptideNamespace::Peptide*> ordered(nScans, nullptr);
+	for(size_t b = 0; b < batchPeptides.size(); b++){
+		const std::vector<size_t>& indices = scheduler->getBatch(b).indices;
+		assert(indices.size() == batchPeptides[b].size());
+		for(size_t i = 0; i < indices.size(); i++)
+			ordered[indices[i]] = &batchPeptides[b][i];
 	}
+	//batchPeptides is discarded, so its peptides are moved instead of copied
+	peptides.clear();
+	peptides.reserve(nScans);
+	for(auto p : ordered)
+		peptides.push_back(std::move(*p));
 
-	delete [] splitPeptides;
-	delete [] sucsses;
 	return true;
 }
 
 /**
- Prints progress bar during findFragmentsParallel. <br>
- \p scansIndex is updated concurrently by each thread.
- \param scansIndex number of scans completed
- \param count total number of scans to search for
- \param sleepTime time before next update is printed (in seconds)
+ Worker thread for findFragmentsParallel. <br>
+ Batches are requested from \p scheduler until there is no work left.
+ Peptides for each batch are added to the corresponding element in \p batchPeptides.
+ \param scans populated list of identified ms2 scans to search for
+ \param scheduler Scheduler to get batches of scans from.
+ \param workerIndex Index of this worker in \p scheduler
+ \param msInterface MsInterface shared by all workers.
+ \param prefetcher Prefetcher reading files into \p msInterface. Notified when each file is reached.
+ \param ladderCache Fragment ladder cache shared by all workers.
+ \param aadbCache Amino acid masses for each sample shared by all workers.
+ \param batchPeptides Vector with an element for each batch in \p scheduler.
+ \param pars IonFinder params object.
+ \param success set to true if function was successful
+ \param progress Incremented for each scan processed.
+ \param stats Populated with timing data for this worker.
  */
-void IonFinder::findFragmentsProgress(std::atomic<size_t>& scansIndex, size_t count,
-									  const std::string& message, int sleepTime)
+void IonFinder::findFragmentsWorker(std::vector<Dtafilter::Scan>& scans,
+                                    ScanScheduler& scheduler, unsigned int workerIndex,
+                                    ms2::MsInterface& msInterface, Prefetcher& prefetcher,
+                                    PeptideNamespace::LadderCache& ladderCache,
+                                    AADBCache& aadbCache,
+                                    std::vector<std::vector<PeptideNamespace::Peptide> >& batchPeptides,
+                                    const IonFinder::Params& pars,
+                                    bool* success, ProgressCounter& progress,
+                                    WorkerStats& stats)
 {
-	size_t lastIndex = scansIndex.load();
-	size_t curIndex = lastIndex;
-	int noChangeIterations = 0;
-
-	std::cout << message << NEW_LINE;
-	while(scansIndex < count)
-	{
-		curIndex = scansIndex.load();
-
-		if(lastIndex == curIndex)
-			noChangeIterations++;
-		else noChangeIterations = 0;
+    *success = false;
+    size_t batchIndex;
+    bool stolen;
+    while(scheduler.next(workerIndex, batchIndex, stolen))
+    {
+        const ScanBatch& batch = scheduler.getBatch(batchIndex);
+        auto batchStart = std::chrono::steady_clock::now();
+
+        // let the prefetcher know which files are in use so it can read further ahead
+        // and count the scans from each file so they can be released when the batch is done
+        std::map<std::string, size_t> fileCounts;
+        std::string lastFile;
+        for(auto i : batch.indices){
+            if(scans[i].getPrecursor().getFile() != lastFile){
+                lastFile = scans[i].getPrecursor().getFile();
+                prefetcher.reached(lastFile);
+            }
+            fileCounts[lastFile]++;
+        }
 
-		if(noChangeIterations > IonFinder::MAX_PROGRESS_ITTERATIONS)
-			throw std::runtime_error("Thread timeout!");
+        // In file affinity mode this worker owns the file, so read it up front.
+        if(!batch.file.empty() && !msInterface.read(batch.file))
+            return;
+
+        bool batchSuccess = false;
+        batchPeptides[batchIndex].reserve(batch.size());
+        IonFinder::findFragments_threadSafe(scans, batch.indices, msInterface, ladderCache, aadbCache,
+                                            batchPeptides[batchIndex], pars,
+                                            &batchSuccess, progress);
+
+        // files are removed once all of their scans have been released
+        for(const auto& count : fileCounts)
+            msInterface.release(count.first, count.second);
+        if(!batchSuccess) return;
+
+        stats.busyTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+        stats.nScans += batch.size();
+        stats.nBatches++;
+        if(stolen) stats.nStolen++;
+    }
+    *success = true;
+}
 
-		utils::printProgress(float(curIndex) / float(count));
-		std::this_thread::sleep_for(std::chrono::seconds(sleepTime));
+/**
+ Print summary of how work was distributed across threads.
+ \param stats Stats for each worker.
+ \param wallTime Elapsed time in seconds.
+ \param verbose Should stats for each individual thread be printed?
+ \param out Stream to print to.
+ */
+void IonFinder::printWorkerStats(const std::vector<WorkerStats>& stats, double wallTime,
+                                 bool verbose, std::ostream& out)
+{
+    if(stats.empty()) return;
+    double minBusy = stats.front().busyTime;
+    double maxBusy = stats.front().busyTime;
+    double totalBusy = 0;
+    for(const auto& s : stats){
+        minBusy = std::min(minBusy, s.busyTime);
+        maxBusy = std::max(maxBusy, s.busyTime);
+        totalBusy += s.busyTime;
+    }
 
-		lastIndex = curIndex;
-	}
-	utils::printProgress(float(scansIndex.load()) / float(count));
-	std::cout << NEW_LINE;
-	std::cout << "Done!" << NEW_LINE;
+    std::streamsize ss = out.precision();
+    out.precision(2);
+    out << std::fixed << "Wall time: " << wallTime << "s, thread busy time (min/mean/max): "
+        << minBusy << "/" << totalBusy / double(stats.size()) << "/" << maxBusy << "s" << NEW_LINE;
+    if(verbose){
+        for(size_t i = 0; i < stats.size(); i++){
+            out << "\tThread " << i << ": " << stats[i].busyTime << "s busy, "
+                << stats[i].nScans << " scans, "
+                << stats[i].nBatches << " batches (" << stats[i].nStolen << " stolen)" << NEW_LINE;
+        }
+    }
+    out.unsetf(std::ios::fixed);
+    out.precision(ss);
 }
 
 /**
@@ -534,10 +707,10 @@ bool IonFinder::findFragments(std::vector<Dtafilter::Scan>& scans,
 							  IonFinder::Params& pars)
 {
 	bool* success = new bool(false);
-	std::atomic<size_t> scansIndex;
+	ProgressCounter progress;
 	IonFinder::findFragments_(scans, 0, scans.size(),
                               peptides, pars,
-							  success, scansIndex);
+							  success, progress);
 
 	bool ret = *success;
 	delete success;
@@ -549,14 +722,16 @@ void IonFinder::findFragments_(std::vector<Dtafilter::Scan>& scans,
                                const size_t beg, const size_t end,
                                std::vector<PeptideNamespace::Peptide>& peptides,
                                const IonFinder::Params& pars,
-                               bool* success, std::atomic<size_t>& scansIndex)
+                               bool* success, ProgressCounter& progress)
 {
     // read ms files
-    ms2::MsInterface msInterface;
+    ms2::MsInterface msInterface(pars.getReaderOptions());
     msInterface.read(scans.begin() + beg, scans.begin() + end);
+    PeptideNamespace::LadderCache ladderCache(pars.getLadderCacheSize());
+    AADBCache aadbCache(pars);
 
-    IonFinder::findFragments_threadSafe(scans, beg, end, msInterface,
-                                        peptides, pars, success, scansIndex);
+    IonFinder::findFragments_threadSafe(scans, beg, end, msInterface, ladderCache, aadbCache,
+                                        peptides, pars, success, progress);
 }
 
 /**
@@ -566,110 +741,168 @@ void IonFinder::findFragments_(std::vector<Dtafilter::Scan>& scans,
  \param peptides empty vector of peptides to be filled from data in scans.
  \param beg index of beginning of scan vector
  \param end index of end of scan vector
+ \param ladderCache Cache of fragment ladders.
+ \param aadbCache Amino acid masses for each sample.
  \param pars IonFinder params object.
  \param success set to true if function was successful
  */
 void IonFinder::findFragments_threadSafe(std::vector<Dtafilter::Scan>& scans,
 										 const size_t beg, const size_t end,
                                          ms2::MsInterface& msInterface,
+                                         PeptideNamespace::LadderCache& ladderCache,
+                                         AADBCache& aadbCache,
 										 std::vector<PeptideNamespace::Peptide>& peptides,
 										 const IonFinder::Params& pars,
-										 bool* success, std::atomic<size_t>& scansIndex)
+										 bool* success, ProgressCounter& progress)
+{
+	std::vector<size_t> indices;
+	indices.reserve(end - beg);
+	for(size_t i = beg; i < end; i++)
+		indices.push_back(i);
+	IonFinder::findFragments_threadSafe(scans, indices, msInterface, ladderCache, aadbCache,
+										peptides, pars, success, progress);
+}
+
+/**
+ Find peptide fragment ions in ms2 files for the scans at \p indices. <br>
+ Peptides are added to \p peptides in the same order as \p indices.
+ Function should not be called directly.
+ Use IonFinder::findFragments or IonFinder::findFragmentsParallel instead.
+ \param indices indices of scans to search for.
+ \param ladderCache Cache of fragment ladders.
+ \param aadbCache Amino acid masses for each sample.
+ \param peptides empty vector of peptides to be filled from data in scans.
+ \param pars IonFinder params object.
+ \param success set to true if function was successful
+ */
+void IonFinder::findFragments_threadSafe(std::vector<Dtafilter::Scan>& scans,
+										 const std::vector<size_t>& indices,
+                                         ms2::MsInterface& msInterface,
+                                         PeptideNamespace::LadderCache& ladderCache,
+                                         AADBCache& aadbCache,
+										 std::vector<PeptideNamespace::Peptide>& peptides,
+										 const IonFinder::Params& pars,
+										 bool* success, ProgressCounter& progress)
 {
 	*success = false;
 	std::string curSample;
-	std::string curWD;
-	std::string spFname;
-	aaDB::AADB aminoAcidMasses;
-	bool aaDBInit = false;
+	const aaDB::AADB* aminoAcidMasses = nullptr;
 	ms2::Spectrum spectrum;
 
-	for(size_t i = beg; i < end; i++)
+	for(size_t i : indices)
 	{
-		if((pars.getInputMode() == DTAFILTER_INPUT_STR && curSample != scans[i].getSampleName()) || !aaDBInit)
+		if(aminoAcidMasses == nullptr || (pars.getInputMode() == DTAFILTER_INPUT_STR && curSample != scans[i].getSampleName()))
 		{
-			//re-init Peptide::AminoAcidMasses for each sample
-			curWD = utils::dirName(scans[i].getPrecursor().getFile());
-			spFname = curWD + "/sequest.params";
-			
-			//read sequest params file and init aadb
-			aminoAcidMasses.clear();
-			if(pars.getInputMode() == DTAFILTER_INPUT_STR)
-                PeptideNamespace::initAminoAcidsMasses(pars, spFname, aminoAcidMasses);
-			else {
-                PeptideNamespace::initAminoAcidsMasses(pars, aminoAcidMasses);
-                if(!pars.getSmodFileSpecified() && pars.getModMass() != 0)
-                    aminoAcidMasses.addMod(aaDB::AminoAcid(std::string(1, constants::MOD_CHAR), pars.getModMass()));
-            }
+			//look up amino acid masses for each sample
+			aminoAcidMasses = &aadbCache.get(scans[i]);
 		}//end if
 		curSample = scans[i].getSampleName();
 		
 		//initialize peptide object for current scan
 		peptides.emplace_back(scans[i].getSequence());
-		peptides.back().initialize(pars, aminoAcidMasses);
-		
-		//add neutral loss fragments to current peptide
-		if(pars.getCalcNL()){
-			peptides.back().addNeutralLoss(pars.getNeutralLossMass(), pars.getLabelArtifactNL());
-		}
-        
-        // std::cout << scans[i].getPrecursor().getFile() << " -> " << scans[i].getScanNum() << NEW_LINE;
-        // peptides.back().printFragments(std::cout, false);
-
-		if(!msInterface.getScan(spectrum,
-                                scans[i].getPrecursor().getFile(),
-                                scans[i].getScanNum()))
-            throw std::runtime_error("Failed to retrieve scan " +
-                                     std::to_string(scans[i].getScanNum()) + " from file " +
-                                     scans[i].getPrecursor().getFile());
-
-        spectrum.setScanData(&scans[i]);
-
-        //set all precursor info except file
-        scans[i].getPrecursor().setMZ(spectrum.getPrecursor().getMZ());
-        scans[i].getPrecursor().setScan(spectrum.getPrecursor().getScan());
-        scans[i].getPrecursor().setRT(spectrum.getPrecursor().getRT());
-        scans[i].getPrecursor().setCharge(spectrum.getPrecursor().getCharge());
-        scans[i].getPrecursor().setIntensity(spectrum.getPrecursor().getIntensity());
-
-        //remove ions below specified intensity
-        spectrum.normalizeIonInts(100);
-        if(pars.getMinIntensitySpecified())
-            spectrum.removeIntensityBelow(pars.getMinIntensity());
-		// spectrum.labelSpectrum(peptides.back(), pars, true); //removes unlabeled ions from peptide
-
-        // label spectrum
-        spectrum.labelSpectrum(peptides.back(), pars);
-
-        //Filter ion intensities
-        if(pars.getMinLabelIntensity() > 0)
-            peptides.back().removeLabelIntensityBelow(pars.getMinLabelIntensity(), false, false);
-        if(pars.getNlIntCo() > 0)
-            peptides.back().removeLabelIntensityBelow(pars.getNlIntCo(), true, false);
-
-		//print spectra file
-		if(pars.getPrintSpectraFiles())
-		{
-			std::string dirNameTemp = (pars.getInDirSpecified() ? pars.getWD() : curWD) + "/spectraFiles";
-			if(!utils::dirExists(dirNameTemp))
-				if(!utils::mkdir(dirNameTemp.c_str(), "-p")){
-					throw std::runtime_error("\nFailed to make dir: " + dirNameTemp);
-				}
+		IonFinder::labelScan(scans[i], msInterface, ladderCache, *aminoAcidMasses, peptides.back(), spectrum, pars);
+		++progress;
+	} //end of for
+	
+	*success = true;
+}
 
-			//spectrum.normalizeIonInts(100);
-			spectrum.calcLabelPos();
+/**
+ Initialize amino acid masses for the sample \p scan belongs to.
+ In DTAFilter input mode, the sequest.params file in the same directory as the MS file for \p scan is used.
+ \param scan Scan to initialize amino acid masses for.
+ \param pars IonFinder params object.
+ \param aminoAcidMasses AADB to initialize.
+ */
+void IonFinder::initAminoAcidMasses(const Dtafilter::Scan& scan,
+                                    const IonFinder::Params& pars,
+                                    aaDB::AADB& aminoAcidMasses)
+{
+	std::string spFname = utils::dirName(scan.getPrecursor().getFile()) + "/sequest.params";
+
+	//read sequest params file and init aadb
+	aminoAcidMasses.clear();
+	if(pars.getInputMode() == DTAFILTER_INPUT_STR)
+		PeptideNamespace::initAminoAcidsMasses(pars, spFname, aminoAcidMasses);
+	else {
+		PeptideNamespace::initAminoAcidsMasses(pars, aminoAcidMasses);
+		if(!pars.getSmodFileSpecified() && pars.getModMass() != 0)
+			aminoAcidMasses.addMod(aaDB::AminoAcid(std::string(1, constants::MOD_CHAR), pars.getModMass()));
+	}
+}
 
-			std::string temp = dirNameTemp + "/" + utils::baseName(scans[i].getOfname());
-			std::ofstream outF((temp).c_str());
-			if(!outF){
-				throw std::runtime_error("\nFailed to write spectrum!");
+/**
+ Calculate fragments for \p peptide and label them in the spectrum for \p scan. <br>
+ Precursor information in \p scan is updated from the spectrum.
+ \param scan Scan to label.
+ \param msInterface MsInterface to get spectrum from.
+ \param ladderCache Cache of fragment ladders shared by PSMs of the same peptide.
+ \param aminoAcidMasses Initialized amino acid masses for sample \p scan belongs to.
+ \param peptide Peptide constructed from the sequence of \p scan.
+ \param spectrum Spectrum object to use as a buffer.
+ \param pars IonFinder params object.
+ */
+void IonFinder::labelScan(Dtafilter::Scan& scan,
+                          ms2::MsInterface& msInterface,
+                          PeptideNamespace::LadderCache& ladderCache,
+                          const aaDB::AADB& aminoAcidMasses,
+                          PeptideNamespace::Peptide& peptide,
+                          ms2::Spectrum& spectrum,
+                          const IonFinder::Params& pars)
+{
+	//calculate fragments with neutral losses or share them from an earlier PSM of the same peptide
+	peptide.initialize(pars, aminoAcidMasses, ladderCache, pars.getCalcNL(),
+	                   pars.getNeutralLossMass(), pars.getLabelArtifactNL());
+
+	if(!msInterface.getScan(spectrum,
+							scan.getPrecursor().getFile(),
+							scan.getScanNum()))
+		throw std::runtime_error("Failed to retrieve scan " +
+								 std::to_string(scan.getScanNum()) + " from file " +
+								 scan.getPrecursor().getFile());
+
+	spectrum.setScanData(&scan);
+
+	//set all precursor info except file
+	scan.getPrecursor().setMZ(spectrum.getPrecursor().getMZ());
+	scan.getPrecursor().setScan(spectrum.getPrecursor().getScan());
+	scan.getPrecursor().setRT(spectrum.getPrecursor().getRT());
+	scan.getPrecursor().setCharge(spectrum.getPrecursor().getCharge());
+	scan.getPrecursor().setIntensity(spectrum.getPrecursor().getIntensity());
+
+	//ions below the specified intensity were already removed by the reader
+	spectrum.normalizeIonInts(100);
+
+	// label spectrum
+	spectrum.labelSpectrum(peptide, pars);
+
+	//Filter ion intensities
+	if(pars.getMinLabelIntensity() > 0)
+		peptide.removeLabelIntensityBelow(pars.getMinLabelIntensity(), false, false);
+	if(pars.getNlIntCo() > 0)
+		peptide.removeLabelIntensityBelow(pars.getNlIntCo(), true, false);
+
+	//print spectra file
+	if(pars.getPrintSpectraFiles())
+	{
+		std::string curWD = utils::dirName(scan.getPrecursor().getFile());
+		std::string dirNameTemp = (pars.getInDirSpecified() ? pars.getWD() : curWD) + "/spectraFiles";
+		if(!utils::dirExists(dirNameTemp))
+			if(!utils::mkdir(dirNameTemp.c_str(), "-p")){
+				throw std::runtime_error("\nFailed to make dir: " + dirNameTemp);
 			}
-			spectrum.printLabeledSpectrum(outF, true);
+
+		//spectrum.normalizeIonInts(100);
+		spectrum.makeLabels(peptide);
+		spectrum.calcLabelPos();
+
+		std::string temp = dirNameTemp + "/" + utils::baseName(scan.getOfname());
+		std::ofstream outF((temp).c_str());
+		if(!outF){
+			throw std::runtime_error("\nFailed to write spectrum!");
 		}
-		scansIndex++;
-	} //end of for
-	
-	*success = true;
+		spectrum.printLabeledSpectrum(outF, true);
+	}
 }
 
 void IonFinder::PeptideStats::calcContainsCit(bool includeCTermMod)
@@ -748,19 +981,135 @@ std::string IonFinder::PeptideStats::containsCitToStr(const ContainsCitType& cc)
 }
 
 /**
- Prints peptide stats to file.
+ Prints peptide stats to file. <br>
+ Rows are formatted in chunks of OUTPUT_CHUNK_ROWS concurrently on \p pool.
+ Chunks are written to the file in order as soon as they are ready, so output is identical
+ regardless of the number of threads.
  \param stats Peptide stats to print.
  \param pars initialized IonFinder::Params object
+ \param pool Thread pool to format rows on.
  \return true if successful.
  */
 bool IonFinder::printPeptideStats(const std::vector<PeptideStats>& stats,
-								  const IonFinder::Params& pars)
+								  const IonFinder::Params& pars,
+								  ThreadPool& pool)
 {
 	//assert(outF);
 	std::ofstream outF (pars.makeOfname());
 	if(!outF) return false;
-	
+
+	printPeptideStatsHeader(outF, pars);
+
+	std::vector<PeptideStats::IonType> ionTypes = printedIonTypes(pars);
+	size_t const nChunks = (stats.size() + OUTPUT_CHUNK_ROWS - 1) / OUTPUT_CHUNK_ROWS;
+	size_t const nThread = std::min<size_t>(pool.size(), std::max<size_t>(nChunks, 1));
+	//max number of formatted chunks waiting to be written
+	size_t const maxInFlight = nThread * 2;
+
+	std::vector<TextBuffer> buffers(nChunks);
+	std::vector<char> ready(nChunks, false);
+	size_t nextChunk = 0;
+	size_t nWritten = 0;
+	//set when a formatter throws, the exception is stored in its future
+	bool formatFailed = false;
+	std::mutex mutex;
+	std::condition_variable cv;
+	ProgressReporter progress("\nWriting peptide stats...", stats.size(), (unsigned int)nThread, !pars.getVerbose());
+
+	auto formatChunks = [&](unsigned int thread){
+		ProgressCounter& counter = progress.getCounter(thread);
+		try{
+			while(true){
+				size_t chunk;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cv.wait(lock, [&]() -> bool {
+						return formatFailed || nextChunk >= nChunks || nextChunk < nWritten + maxInFlight;
+					});
+					if(formatFailed || nextChunk >= nChunks) return;
+					chunk = nextChunk++;
+				}
+				size_t end = std::min(stats.size(), (chunk + 1) * OUTPUT_CHUNK_ROWS);
+				for(size_t i = chunk * OUTPUT_CHUNK_ROWS; i < end; i++)
+					printPeptideStatsRow(buffers[chunk], stats[i], ionTypes, pars);
+				counter.add(end - chunk * OUTPUT_CHUNK_ROWS);
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					ready[chunk] = true;
+				}
+				cv.notify_all();
+			}
+		} catch(...){
+			//wake the writer and the other formatters so they stop instead of waiting for this one's chunks
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				formatFailed = true;
+			}
+			cv.notify_all();
+			throw;
+		}
+	};
+
+	progress.start();
+	std::vector<std::future<void> > formatters;
+	for(size_t i = 0; i < nThread; i++)
+		formatters.push_back(pool.submit(std::bind(formatChunks, (unsigned int)i)));
+
+	//write chunks in order
+	bool success = true;
+	for(size_t i = 0; i < nChunks; i++){
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [&]() -> bool { return formatFailed || ready[i] != 0; });
+			if(!ready[i]) break;
+		}
+		if(success && !buffers[i].write(outF))
+			success = false;
+		buffers[i].release();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			nWritten = i + 1;
+		}
+		cv.notify_all();
+	}
+	//every formatter must stop before the locals it uses go out of scope
+	for(auto& formatter : formatters)
+		formatter.wait();
+	for(auto& formatter : formatters)
+		formatter.get();
+	progress.finish();
+
+	return success;
+}
+
+/**
+ Get the ion types which are printed in the peptide stats output based on the analysis performed.
+ \param pars initialized IonFinder::Params object
+ \return Ion types in the order they are printed.
+ */
+std::vector<IonFinder::PeptideStats::IonType> IonFinder::printedIonTypes(const IonFinder::Params& pars)
+{
 	typedef IonFinder::PeptideStats::IonType itcType;
+	std::vector<itcType> _pepStats;
+	//defaults
+	_pepStats.push_back(itcType::FRAG);
+	_pepStats.push_back(itcType::DET);
+	_pepStats.push_back(itcType::AMB);
+	//conditional stats
+	if(pars.getCalcNL()){
+		_pepStats.push_back(itcType::DET_NL);
+		_pepStats.push_back(itcType::ART_NL);
+	}
+	return _pepStats;
+}
+
+/**
+ Print header line for peptide stats output.
+ \param outF Stream to print to.
+ \param pars initialized IonFinder::Params object
+ */
+void IonFinder::printPeptideStatsHeader(std::ostream& outF, const IonFinder::Params& pars)
+{
 	//build stat names vector
 	std::vector<std::string> statNames;
 	
@@ -774,16 +1123,7 @@ bool IonFinder::printPeptideStats(const std::vector<PeptideStats>& stats,
 	}
 	
 	//determine when to stop printing peptide stats based on analysis performed
-	std::vector<itcType> _pepStats; //used to store relevant peptide stats based on params
-	//defaults
-	_pepStats.push_back(itcType::FRAG);
-	_pepStats.push_back(itcType::DET);
-	_pepStats.push_back(itcType::AMB);
-	//conditional stats
-	if(pars.getCalcNL()){
-		_pepStats.push_back(itcType::DET_NL);
-		_pepStats.push_back(itcType::ART_NL);
-	}
+	std::vector<PeptideStats::IonType> _pepStats = printedIonTypes(pars);
 	
 	//append peptide stats names to headers
 	int statLen = 0;
@@ -820,87 +1160,102 @@ bool IonFinder::printPeptideStats(const std::vector<PeptideStats>& stats,
 		else outF << OUT_DELIM << headers[i];
 	}
 	outF << NEW_LINE;
+}
+
+/**
+ Format a single row of peptide stats output.
+ \param outF Buffer to append row to.
+ \param stat Peptide stats to print.
+ \param _pepStats Ion types to print. Should be the value returned by printedIonTypes.
+ \param pars initialized IonFinder::Params object
+ */
+void IonFinder::printPeptideStatsRow(TextBuffer& outF, const PeptideStats& stat,
+									 const std::vector<PeptideStats::IonType>& _pepStats,
+									 const IonFinder::Params& pars)
+{
+	typedef IonFinder::PeptideStats::IonType itcType;
+	//scan data
+	if(pars.getPrintPeptideUID())
+		outF << stat._id << OUT_DELIM;
+
+	outF << stat._scan->getParentID() <<
+		OUT_DELIM << stat._scan->getParentProtein() <<
+		OUT_DELIM << stat._scan->getParentDescription() <<
+		OUT_DELIM << stat._scan->getFullSequence() <<
+		OUT_DELIM << scanData::removeStaticMod(stat._scan->getSequence()) <<
+		OUT_DELIM << stat._scan->getFormula() <<
+		OUT_DELIM << stat._scan->getPrecursor().getMZ() <<
+		OUT_DELIM << (!stat.modLocs.empty()) <<
+		OUT_DELIM << stat.modResidues <<
+		OUT_DELIM << stat._scan->getPrecursor().getCharge() <<
+		OUT_DELIM << stat._scan->getUnique() <<
+		OUT_DELIM << stat._scan->getXcorr() <<
+		OUT_DELIM << stat._scan->getSpectralCounts() <<
+		OUT_DELIM << stat._scan->getScanNum() <<
+		OUT_DELIM << stat._scan->getPrecursor().getScan() <<
+		OUT_DELIM << stat._scan->getPrecursor().getRT() <<
+		OUT_DELIM << utils::baseName(stat._scan->getPrecursor().getFile()) <<
+		OUT_DELIM << stat._scan->getSampleName();
 	
-	//print data
-	for(const auto & stat : stats)
-	{
-		//scan data
-		if(pars.getPrintPeptideUID())
-			outF << stat._id << OUT_DELIM;
-
-        outF << stat._scan->getParentID() <<
-			OUT_DELIM << stat._scan->getParentProtein() <<
-			OUT_DELIM << stat._scan->getParentDescription() <<
-			OUT_DELIM << stat._scan->getFullSequence() <<
-			OUT_DELIM << scanData::removeStaticMod(stat._scan->getSequence()) <<
-			OUT_DELIM << stat._scan->getFormula() <<
-			OUT_DELIM << stat._scan->getPrecursor().getMZ() <<
-			OUT_DELIM << (!stat.modLocs.empty()) <<
-			OUT_DELIM << stat.modResidues <<
-			OUT_DELIM << stat._scan->getPrecursor().getCharge() <<
-			OUT_DELIM << stat._scan->getUnique() <<
-			OUT_DELIM << stat._scan->getXcorr() <<
-			OUT_DELIM << stat._scan->getSpectralCounts() <<
-			OUT_DELIM << stat._scan->getScanNum() <<
-			OUT_DELIM << stat._scan->getPrecursor().getScan() <<
-			OUT_DELIM << stat._scan->getPrecursor().getRT() <<
-			OUT_DELIM << utils::baseName(stat._scan->getPrecursor().getFile()) <<
-			OUT_DELIM << stat._scan->getSampleName();
-		
-		//peptide analysis data
+	//peptide analysis data
+	outF << OUT_DELIM;
+	if(pars.getCalcNL())
+		 outF << PeptideStats::containsCitToStr(stat.containsCit);
+	else{
+		outF << (stat.ionTypesCount.at(itcType::DET).size() > 0);
+	}
+	if(pars.getGroupMod() == 0){
 		outF << OUT_DELIM;
 		if(pars.getCalcNL())
-			 outF << PeptideStats::containsCitToStr(stat.containsCit);
+			outF << PeptideStats::containsCitToStr(stat.thisContainsCit);
 		else{
 			outF << (stat.ionTypesCount.at(itcType::DET).size() > 0);
 		}
-		if(pars.getGroupMod() == 0){
-            outF << OUT_DELIM;
-            if(pars.getCalcNL())
-                outF << PeptideStats::containsCitToStr(stat.thisContainsCit);
-            else{
-                outF << (stat.ionTypesCount.at(itcType::DET).size() > 0);
-            }
-            outF << OUT_DELIM << stat.modIndex;
-		}
-
-		// ion counts
-		for(auto & _pepStat : _pepStats)
-			outF << OUT_DELIM << stat.ionTypesCount.at(_pepStat).size();
+		outF << OUT_DELIM << stat.modIndex;
+	}
 
-		// list individual ions
-		for(auto & _pepStat : _pepStats){
-			outF << OUT_DELIM;
-            for(auto it = stat.ionTypesCount.at(_pepStat).begin();
-                it != stat.ionTypesCount.at(_pepStat).end();
-                ++it)
-            {
-                if(it == stat.ionTypesCount.at(_pepStat).begin())
-                    outF << it->getIonStr();
-                else outF << stat._fragDelim << it->getIonStr();
-            }
-        }
+	// ion counts
+	for(auto & _pepStat : _pepStats)
+		outF << OUT_DELIM << stat.ionTypesCount.at(_pepStat).size();
+
+	// ion labels are made here and printed in alphabetical order
+	typedef std::pair<std::string, double> LabelIntensity;
+	std::vector<std::vector<LabelIntensity> > ionLabels(_pepStats.size());
+	for(size_t i = 0; i < _pepStats.size(); i++){
+		const PeptideStats::IonStrings& ions = stat.ionTypesCount.at(_pepStats[i]);
+		ionLabels[i].reserve(ions.size());
+		for(const auto& ion : ions)
+			ionLabels[i].emplace_back(stat.getIonStr(ion), ion.getIntensity());
+		std::sort(ionLabels[i].begin(), ionLabels[i].end());
+	}
 
-		if(pars.getPrintIonIntensity()) {
-            // list individual ion intensities
-            for (auto &_pepStat : _pepStats) {
-                outF << OUT_DELIM;
-                for (auto it = stat.ionTypesCount.at(_pepStat).begin();
-                     it != stat.ionTypesCount.at(_pepStat).end();
-                     ++it) {
-                    if (it == stat.ionTypesCount.at(_pepStat).begin())
-                        outF << it->getIntensity();
-                    else outF << stat._fragDelim << it->getIntensity();
-                }
-            }
+	// list individual ions
+	for(const auto& labels : ionLabels){
+		outF << OUT_DELIM;
+		for(auto it = labels.begin(); it != labels.end(); ++it)
+		{
+			if(it == labels.begin())
+				outF << it->first;
+			else outF << stat._fragDelim << it->first;
+		}
+	}
 
-            // total intensities
-            for (auto &_pepStat : _pepStats)
-                outF << OUT_DELIM << stat.fragmentIntensity(_pepStat);
-        }
+	if(pars.getPrintIonIntensity()) {
+		// list individual ion intensities
+		for (const auto& labels : ionLabels) {
+			outF << OUT_DELIM;
+			for (auto it = labels.begin(); it != labels.end(); ++it) {
+				if (it == labels.begin())
+					outF << it->second;
+				else outF << stat._fragDelim << it->second;
+			}
+		}
 
-		outF << NEW_LINE;
+		// total intensities
+		for (auto &_pepStat : _pepStats)
+			outF << OUT_DELIM << stat.fragmentIntensity(_pepStat);
 	}
-	return true;
+
+	outF << NEW_LINE;
 }
 
@@ -35,11 +35,26 @@
  */
 bool Dtafilter::readFilterFiles(const IonFinder::Params& params,
 								std::vector<Dtafilter::Scan>& scans)
+{
+	return Dtafilter::readFilterFiles(params, [&scans](Dtafilter::Scan& scan) -> bool {
+		scans.push_back(scan);
+		return true;
+	});
+}
+
+/**
+ Read list of filter files supplied by \p params and pass each scan to \p callback as it is read.
+ \param params initialized Params object
+ \param callback Called for each scan. If it returns false, reading stops.
+ \returns true if all files were successfully read.
+ */
+bool Dtafilter::readFilterFiles(const IonFinder::Params& params,
+								const Dtafilter::ScanCallback& callback)
 {
 	auto endIt = params.getFilterFiles().end();
 	for(auto it = params.getFilterFiles().begin(); it != endIt; ++it)
 	{
-		if(!Dtafilter::readFilterFile(it->second, it->first, scans,
+		if(!Dtafilter::readFilterFile(it->second, it->first, callback,
 									  !params.getIncludeReverse(), params.getModFilter()))
 			return false;
 	}
@@ -79,12 +94,43 @@ bool IonFinder::readInputTsv(const std::string& ifname,
 							 std::vector<Dtafilter::Scan>& scans,
 							 bool skipReverse, int modFilter)
 {
-	utils::TsvFile tsv(ifname);
-	if(!tsv.read()) return false;
-	
+	return IonFinder::readInputTsv(ifname, [&scans](Dtafilter::Scan& scan) -> bool {
+		scans.push_back(scan);
+		return true;
+	}, skipReverse, modFilter);
+}
+
+/**
+ Read tsv formatted peptide list and pass each scan to \p callback. <br>
+ Rows are passed to \p callback as they are read. gzip compressed files are decompressed
+ on a background thread while they are read.
+ \param ifname path of .tsv file of peptides to search for
+ \param callback Called for each scan. If it returns false, reading stops.
+ \param skipReverse Should reverse peptide matches be skipped?
+ \param modFilter Which scans should be passed to \p callback?
+ 0: only modified, 1: all peptides regardless of modification, 2: only unmodified pepeitde.
+
+ \returns true if all files were successfully read and \p callback never returned false.
+ */
+bool IonFinder::readInputTsv(const std::string& ifname,
+							 const Dtafilter::ScanCallback& callback,
+							 bool skipReverse, int modFilter)
+{
+	gzip::IfStream inF(ifname);
+	if(!inF) return false;
+
+	//read header
+	std::string line;
+	std::vector<std::string> elems;
+	if(!utils::safeGetline(inF, line)) return false;
+	utils::split(line, IN_DELIM, elems);
+	std::map<std::string, size_t> cols;
+	for(size_t i = 0; i < elems.size(); i++)
+		cols[elems[i]] = i;
+
 	//iterate through columns to make sure all required cols exist
 	for(const auto & i : TSV_INPUT_REQUIRED_COLNAMES) {
-		if(!tsv.colExists(i))
+		if(cols.find(i) == cols.end())
 		{
 			std::cerr << "\nError! Required column: " << i <<
 			" not found in " << ifname << NEW_LINE;
@@ -95,48 +141,54 @@ bool IonFinder::readInputTsv(const std::string& ifname,
 	//itterate through columns and search for optional columns
 	std::map<std::string, bool> foundOptionalCols;
 	for(int i = 0; i < TSV_INPUT_OPTIONAL_COLNAMES_LEN; i++)
+		foundOptionalCols[TSV_INPUT_OPTIONAL_COLNAMES[i]] = cols.find(TSV_INPUT_OPTIONAL_COLNAMES[i]) != cols.end();
+
+	//value of column in current row
+	auto getValStr = [&cols, &elems](const std::string& colName) -> std::string {
+		size_t col = cols.at(colName);
+		return col < elems.size() ? elems[col] : "";
+	};
+
+	while(utils::safeGetline(inF, line))
 	{
-		if(tsv.colExists(TSV_INPUT_OPTIONAL_COLNAMES[i]))
-			foundOptionalCols[TSV_INPUT_OPTIONAL_COLNAMES[i]] = true;
-		else foundOptionalCols[TSV_INPUT_OPTIONAL_COLNAMES[i]] = false;
-	}
-	
-	size_t nRow = tsv.getNrow();
-	for(size_t i = 0; i < nRow; i++)
-	{
+		if(line.empty()) continue;
+		utils::split(line, IN_DELIM, elems);
+
 		Dtafilter::Scan temp;
 		temp.setMatchDirection(Dtafilter::Scan::MatchDirection::FORWARD);
 
 		//required columns
-		temp.setScanNum(tsv.getValSize(i, IonFinder::SCAN_NUM));
-		temp.setSequence(tsv.getValStr(i, IonFinder::SEQUENCE));
+		temp.setScanNum(std::strtoul(getValStr(IonFinder::SCAN_NUM).c_str(), nullptr, 10));
+		temp.setSequence(getValStr(IonFinder::SEQUENCE));
         temp.setIsModified(temp.checkIsModified());
-		temp.getPrecursor().setFile(tsv.getValStr(i, IonFinder::PRECURSOR_FILE));
-		temp.setSampleName(tsv.getValStr(i, IonFinder::SAMPLE_NAME));
+		temp.getPrecursor().setFile(getValStr(IonFinder::PRECURSOR_FILE));
+		temp.setSampleName(getValStr(IonFinder::SAMPLE_NAME));
 
 		//add optional columns which were found.
 		if(foundOptionalCols[IonFinder::PARENT_ID])
-			temp.setParentID(tsv.getValStr(i, IonFinder::PARENT_ID));
+			temp.setParentID(getValStr(IonFinder::PARENT_ID));
 		if(foundOptionalCols[IonFinder::PARENT_PROTEIN])
-			temp.setParentProtein(tsv.getValStr(i, IonFinder::PARENT_PROTEIN));
+			temp.setParentProtein(getValStr(IonFinder::PARENT_PROTEIN));
 		if(foundOptionalCols[IonFinder::PARENT_DESCRIPTION])
-			temp.setParentDescription(tsv.getValStr(i, IonFinder::PARENT_DESCRIPTION));
+			temp.setParentDescription(getValStr(IonFinder::PARENT_DESCRIPTION));
 		if(foundOptionalCols[IonFinder::MATCH_DIRECTION])
-			temp.setMatchDirection(Dtafilter::Scan::strToMatchDirection(tsv.getValStr(i, IonFinder::MATCH_DIRECTION)));
+			temp.setMatchDirection(Dtafilter::Scan::strToMatchDirection(getValStr(IonFinder::MATCH_DIRECTION)));
         if(foundOptionalCols[IonFinder::FORMULA])
-            temp.setFormula(tsv.getValStr(i, IonFinder::FORMULA));
+            temp.setFormula(getValStr(IonFinder::FORMULA));
 		if(foundOptionalCols[IonFinder::FULL_SEQUENCE])
-			temp.setFullSequence(tsv.getValStr(i, IonFinder::FULL_SEQUENCE));
-		if(foundOptionalCols[IonFinder::UNIQUE])
-			temp.setUnique(tsv.getValBool(i, IonFinder::UNIQUE));
+			temp.setFullSequence(getValStr(IonFinder::FULL_SEQUENCE));
+		if(foundOptionalCols[IonFinder::UNIQUE]) {
+			std::string unique = utils::toLower(getValStr(IonFinder::UNIQUE));
+			temp.setUnique(unique == "true" || unique == "1");
+		}
 		if(foundOptionalCols[IonFinder::CHARGE])
-			temp.getPrecursor().setCharge(tsv.getValInt(i, IonFinder::CHARGE));
+			temp.getPrecursor().setCharge(std::atoi(getValStr(IonFinder::CHARGE).c_str()));
 		if(foundOptionalCols[IonFinder::SCORE])
-			temp.setXcorr(tsv.getValStr(i, IonFinder::SCORE));
+			temp.setXcorr(getValStr(IonFinder::SCORE));
 		if(foundOptionalCols[IonFinder::PRECURSOR_MZ])
-			temp.getPrecursor().setMZ(tsv.getValStr(i, IonFinder::PRECURSOR_MZ));
+			temp.getPrecursor().setMZ(getValStr(IonFinder::PRECURSOR_MZ));
 		if(foundOptionalCols[IonFinder::PRECURSOR_SCAN])
-            temp.getPrecursor().setScan(tsv.getValStr(i, IonFinder::PRECURSOR_SCAN));
+            temp.getPrecursor().setScan(getValStr(IonFinder::PRECURSOR_SCAN));
 		
 		//reverse match filter
 		if(skipReverse && temp.getMatchDirection() == Dtafilter::Scan::MatchDirection::REVERSE)
@@ -147,8 +199,86 @@ bool IonFinder::readInputTsv(const std::string& ifname,
 		   (modFilter == 2 && temp.isModified()))
 			continue;
 		
-		scans.push_back(temp);
+		if(!callback(temp)) return false;
 	}
 	
+	//a compressed file which could not be decompressed ends early
+	if(inF.failed() || inF.bad()){
+		std::cerr << "\nError reading " << ifname << NEW_LINE;
+		return false;
+	}
+	return true;
+}
+
+/**
+ Read all input files supplied by \p pars and pass each scan to \p callback as it is read.
+ \param pars initialized Params object
+ \param callback Called for each scan. If it returns false, reading stops.
+ \returns true if all files were successfully read.
+ */
+bool IonFinder::readInputFiles(const IonFinder::Params& pars,
+							   const Dtafilter::ScanCallback& callback)
+{
+	if(pars.getInputMode() == IonFinder::DTAFILTER_INPUT_STR)
+		return Dtafilter::readFilterFiles(pars, callback);
+
+	assert(pars.getInputMode() == IonFinder::TSV_INPUT_STR);
+	for(const auto& file : pars.getInputDirs()) {
+		if(!IonFinder::readInputTsv(file, callback, !pars.getIncludeReverse(), pars.getModFilter()))
+			return false;
+	}
+	return true;
+}
+
+/**
+ Read all input files supplied by \p pars into \p scans. <br>
+ Each file is parsed as a separate task on \p pool. Scans are appended to \p scans
+ in the same order as they would be read sequentially.
+ \param pars initialized Params object
+ \param scans empty list of scans to fill
+ \param pool Thread pool to read files on.
+ \returns true if all files were successfully read.
+ */
+bool IonFinder::readInputFiles(const IonFinder::Params& pars,
+							   std::vector<Dtafilter::Scan>& scans,
+							   IonFinder::ThreadPool& pool)
+{
+	//one reader for each input file
+	std::vector<std::function<bool(const Dtafilter::ScanCallback&)> > readers;
+	if(pars.getInputMode() == IonFinder::DTAFILTER_INPUT_STR) {
+		for(const auto& file : pars.getFilterFiles()) {
+			readers.push_back([&pars, &file](const Dtafilter::ScanCallback& callback) -> bool {
+				return Dtafilter::readFilterFile(file.second, file.first, callback,
+												 !pars.getIncludeReverse(), pars.getModFilter());
+			});
+		}
+	}
+	else {
+		assert(pars.getInputMode() == IonFinder::TSV_INPUT_STR);
+		for(const auto& file : pars.getInputDirs()) {
+			readers.push_back([&pars, &file](const Dtafilter::ScanCallback& callback) -> bool {
+				return IonFinder::readInputTsv(file, callback, !pars.getIncludeReverse(), pars.getModFilter());
+			});
+		}
+	}
+
+	size_t const nFiles = readers.size();
+	std::vector<std::vector<Dtafilter::Scan> > fileScans(nFiles);
+	std::unique_ptr<bool[]> success(new bool[nFiles]);
+	pool.parallelFor(0, nFiles, 1, [&](size_t beg, size_t end){
+		for(size_t i = beg; i < end; i++) {
+			std::vector<Dtafilter::Scan>& dest = fileScans[i];
+			success[i] = readers[i]([&dest](Dtafilter::Scan& scan) -> bool {
+				dest.push_back(scan);
+				return true;
+			});
+		}
+	});
+
+	for(size_t i = 0; i < nFiles; i++) {
+		if(!success[i]) return false;
+		scans.insert(scans.end(), fileScans[i].begin(), fileScans[i].end());
+		std::vector<Dtafilter::Scan>().swap(fileScans[i]);
+	}
 	return true;
 }
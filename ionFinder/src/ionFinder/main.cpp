@@ -29,18 +29,36 @@
 
 int main(int argc, const char** argv)
 {
+	if(IonFinder::isCacheCommand(argc, argv))
+		return IonFinder::runCacheCommand(argc, argv);
+
 	IonFinder::Params pars;
 	if(!pars.getArgs(argc, argv))
 		return 1;
 	
 	pars.printVersion(std::cout);
 
+	//one pool shared by every phase
+	IonFinder::ThreadPool pool(pars.getNumThreads());
+
+	if(pars.getStream())
+	{
+		IonFinder::StreamPipeline pipeline(pars, pool);
+		if(!pipeline.run())
+		{
+			std::cerr << "Failed to write peptide stats!" << NEW_LINE;
+			return 1;
+		}
+		std::cout << "\nResults written to: " << pars.makeOfname() << NEW_LINE;
+		return 0;
+	}
+
 	//read input files
 	std::vector<Dtafilter::Scan> scans;
 	if(pars.getInputMode() == IonFinder::DTAFILTER_INPUT_STR)
 	{
 		std::cout << "\nReading DTAFilter-files...";
-		if(!Dtafilter::readFilterFiles(pars, scans))
+		if(!IonFinder::readInputFiles(pars, scans, pool))
 		{
 			std::cerr << "Failed to read DTASelect-filter files!" << NEW_LINE;
 			return 1;
@@ -50,20 +68,17 @@ int main(int argc, const char** argv)
 	else{
 		assert(pars.getInputMode() == IonFinder::TSV_INPUT_STR);
 		std::cout << "\nReading input .tsv files...";
-		for(auto file: pars.getInputDirs())
-		{
-            if(!IonFinder::readInputTsv(file,scans, !pars.getIncludeReverse(), pars.getModFilter())) {
-                std::cerr << "Failed to read input .tsv files!" << NEW_LINE;
-                return 1;
-            }
-        }
+		if(!IonFinder::readInputFiles(pars, scans, pool)) {
+			std::cerr << "Failed to read input .tsv files!" << NEW_LINE;
+			return 1;
+		}
 		std::cout << "Done!\n";
 	}
 	
 	//calculate and find fragments
 	std::vector<PeptideNamespace::Peptide> peptides;
 	peptides.reserve(scans.size());
-	if(!IonFinder::findFragmentsParallel(scans, peptides, pars)){
+	if(!IonFinder::findFragmentsParallel(scans, peptides, pars, pool)){
 		std::cout << "Failed to annotate spectra!" << std::endl;
 	}
 
@@ -75,11 +90,9 @@ int main(int argc, const char** argv)
 	*/
 
 	//analyze sequences
-	std::cout << "\nAnalyzing peptide sequences...";
 	std::vector<IonFinder::PeptideStats> peptideStats;
-	if(!IonFinder::analyzeSequences(scans, peptides, peptideStats, pars))
+	if(!IonFinder::analyzeSequences(scans, peptides, peptideStats, pars, pool))
 		std::cout << NEW_LINE;
-	std::cout << "Done!\n";
 
 	/*
 	assert(IonFinder::printFragmentIntensities(peptideStats,
@@ -88,7 +101,7 @@ int main(int argc, const char** argv)
     */
 	
 	//write data
-	if(!IonFinder::printPeptideStats(peptideStats, pars))
+	if(!IonFinder::printPeptideStats(peptideStats, pars, pool))
 	{
 		std::cerr << "Failed to write peptide stats!" << NEW_LINE;
 		return 1;
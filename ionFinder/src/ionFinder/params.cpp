@@ -494,6 +494,186 @@ bool IonFinder::Params::getArgs(int argc, const char* const argv[])
             _numThread = computeThreads();
             continue;
         }
+        if(!strcmp(argv[i], "--fileAffinity"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(!(!strcmp(argv[i], "0") || !strcmp(argv[i], "1")))
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _fileAffinity = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--prefetch"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(std::stoi(argv[i]) < 0)
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _prefetchDepth = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--nIoThread"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(std::stoi(argv[i]) < 1)
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _numIoThread = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--stream"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(!(!strcmp(argv[i], "0") || !strcmp(argv[i], "1")))
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _stream = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--scanIndex"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(!(!strcmp(argv[i], "0") || !strcmp(argv[i], "1")))
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _scanIndex = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--mmap"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(!(!strcmp(argv[i], "0") || !strcmp(argv[i], "1")))
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _mmap = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--maxMemory"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(std::stoi(argv[i]) < 0)
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _maxMemory = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--binaryCache"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(!(!strcmp(argv[i], "0") || !strcmp(argv[i], "1")))
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _binaryCache = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--topPeaks"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(std::stoi(argv[i]) < 0)
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _topPeaks = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--windowPeaks"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(std::stoi(argv[i]) < 0)
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _windowPeaks = std::stoi(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--peakWindow"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(std::stod(argv[i]) <= 0)
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _peakWindow = std::stod(argv[i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "--ladderCache"))
+        {
+            if(!utils::isArg(argv[++i]))
+            {
+                usage(IonFinder::ARG_REQUIRED_STR + argv[i-1]);
+                return false;
+            }
+            if(std::stoi(argv[i]) < 0)
+            {
+                std::cerr << argv[i] << base::PARAM_ERROR_MESSAGE << argv[i-1] << NEW_LINE;
+                return false;
+            }
+            _ladderCacheSize = std::stoi(argv[i]);
+            continue;
+        }
         if(!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
         {
             verbose = true;
@@ -559,7 +739,7 @@ bool IonFinder::Params::getFlist(bool force)
     }
     for(auto& _inDir : _inDirs)
     {
-        std::string fname = (_inDirSpecified ? (_wd + _inDir) : _inDir) + ("/" + _dtaFilterBase);
+        std::string fname = gzip::findFile((_inDirSpecified ? (_wd + _inDir) : _inDir) + ("/" + _dtaFilterBase));
         if(utils::fileExists(fname)){
             _filterFiles[utils::baseName(_inDir)] = fname;
         }
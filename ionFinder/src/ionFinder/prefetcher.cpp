@@ -0,0 +1,120 @@
+//
+// prefetcher.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <ionFinder/prefetcher.hpp>
+
+/**
+ * \param msInterface MsInterface to read files into.
+ * \param files MS files in the order they will be needed. Duplicate file names are ignored.
+ * \param depth Maximum number of files to read ahead of workers.
+ */
+IonFinder::Prefetcher::Prefetcher(ms2::MsInterface& msInterface, const std::vector<std::string>& files, size_t depth)
+    : _msInterface(msInterface), _nRead(0)
+{
+    for(const auto& file : files){
+        if(_fileIndex.emplace(file, _files.size()).second)
+            _files.push_back(file);
+    }
+    _reached = std::vector<bool>(_files.size(), false);
+    _depth = depth;
+    _next = 0;
+    _ahead = 0;
+    _stop = false;
+}
+
+IonFinder::Prefetcher::~Prefetcher(){
+    stop();
+}
+
+/**
+ * Spawn I/O threads.
+ * \param nThread Number of I/O threads.
+ */
+void IonFinder::Prefetcher::start(unsigned int nThread)
+{
+    if(_depth == 0) return;
+    for(unsigned int i = 0; i < nThread; i++)
+        _threads.emplace_back(&Prefetcher::ioWorker, this);
+}
+
+//! Read files until all files have been read or stop() is called.
+void IonFinder::Prefetcher::ioWorker()
+{
+    while(true)
+    {
+        size_t i;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() -> bool { return _stop || _next >= _files.size() || _ahead < _depth; });
+            while(_next < _files.size() && _reached[_next]) _next++;
+            if(_stop || _next >= _files.size()) return;
+            i = _next++;
+            _ahead++;
+        }
+
+        // A worker may have reached the file since it was claimed. The worker reads it instead.
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(_reached[i]) continue;
+        }
+
+        // Files which do not fit in the memory budget are skipped and read by the worker which needs them.
+        // Errors are not reported here. The worker which needs the file will report them when it reads the file.
+        if(_msInterface.prefetch(_files[i]))
+            _nRead++;
+    }
+}
+
+/**
+ * Notify the prefetcher that a worker has started using \p file.
+ * This function is thread safe.
+ * \param file MS file name.
+ */
+void IonFinder::Prefetcher::reached(const std::string& file)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = _fileIndex.find(file);
+    if(it == _fileIndex.end() || _reached[it->second]) return;
+    _reached[it->second] = true;
+    if(it->second < _next){
+        _ahead--;
+        cv.notify_all();
+    }
+}
+
+//! Stop reading files and wait for I/O threads to exit.
+void IonFinder::Prefetcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        _stop = true;
+    }
+    cv.notify_all();
+    for(auto& thread : _threads)
+        thread.join();
+    _threads.clear();
+}
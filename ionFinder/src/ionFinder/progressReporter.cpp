@@ -0,0 +1,171 @@
+//
+// progressReporter.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <ionFinder/progressReporter.hpp>
+
+/**
+ * \param message Message printed before progress bar.
+ * \param total Total number of items to process. Use 0 if the total is not known.
+ * \param nThread Number of threads which will update a counter.
+ * \param show Should the progress bar be printed? If false, only \p message and "Done!" are printed.
+ */
+IonFinder::ProgressReporter::ProgressReporter(std::string message, size_t total, unsigned int nThread, bool show)
+    : _counters(std::max(nThread, 1u))
+{
+    _message = std::move(message);
+    _total = total;
+    _show = show;
+    _done = false;
+    _started = false;
+}
+
+IonFinder::ProgressReporter::~ProgressReporter(){
+    finish();
+}
+
+//! Print message and start reporter thread.
+void IonFinder::ProgressReporter::start()
+{
+    if(_started) return;
+    _started = true;
+    _startTime = std::chrono::steady_clock::now();
+    std::cout << _message;
+    if(_show){
+        std::cout << NEW_LINE;
+        _thread = std::thread(&ProgressReporter::run, this);
+    }
+    std::cout.flush();
+}
+
+/**
+ * Stop reporter thread and print final progress.
+ * Should be called once all threads updating counters are finished.
+ */
+void IonFinder::ProgressReporter::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!_started || _done) return;
+        _done = true;
+    }
+    cv.notify_all();
+    if(_thread.joinable()){
+        _thread.join();
+        print(std::cout);
+        std::cout << NEW_LINE;
+    }
+    std::cout << "Done!" << NEW_LINE;
+}
+
+//! Total number of items completed by all threads.
+size_t IonFinder::ProgressReporter::count() const
+{
+    size_t ret = 0;
+    for(const auto& counter : _counters)
+        ret += counter.get();
+    return ret;
+}
+
+double IonFinder::ProgressReporter::elapsed() const{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+}
+
+//! Print progress every PROGRESS_SLEEP_TIME seconds until finish() is called.
+void IonFinder::ProgressReporter::run()
+{
+    size_t lastCount = count();
+    int noChangeIterations = 0;
+    bool warned = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while(!_done)
+    {
+        print(std::cout);
+        std::cout.flush();
+
+        if(cv.wait_for(lock, std::chrono::seconds(PROGRESS_SLEEP_TIME), [this]() -> bool { return _done; }))
+            break;
+
+        size_t curCount = count();
+        if(curCount == lastCount) noChangeIterations++;
+        else noChangeIterations = 0;
+        lastCount = curCount;
+
+        if(noChangeIterations > MAX_PROGRESS_ITTERATIONS && !warned){
+            std::cerr << NEW_LINE << "WARN: No progress in "
+                      << noChangeIterations * PROGRESS_SLEEP_TIME << " seconds!" << NEW_LINE;
+            warned = true;
+        }
+    }
+}
+
+/**
+ * Print a single progress line, overwriting the previous one.
+ * \param out Stream to print to.
+ */
+void IonFinder::ProgressReporter::print(std::ostream& out) const
+{
+    size_t curCount = count();
+    double seconds = elapsed();
+    double rate = seconds > 0 ? double(curCount) / seconds : 0;
+    char buf[64];
+
+    out << '\r';
+    if(_total > 0){
+        double fraction = std::min(1.0, double(curCount) / double(_total));
+        int pos = int(PROGRESS_BAR_WIDTH * fraction);
+        out << '[';
+        for(int i = 0; i < PROGRESS_BAR_WIDTH; i++){
+            if(i < pos) out << '=';
+            else if(i == pos) out << '>';
+            else out << ' ';
+        }
+        std::snprintf(buf, sizeof(buf), "] %3d%% ", int(fraction * 100.0));
+        out << buf << curCount << '/' << _total;
+    }
+    else out << curCount;
+
+    std::snprintf(buf, sizeof(buf), " %.1f/s", rate);
+    out << buf;
+
+    if(_total > 0 && curCount < _total && rate > 0){
+        auto eta = (unsigned long)(double(_total - curCount) / rate);
+        std::snprintf(buf, sizeof(buf), " ETA %lu:%02lu", eta / 60, eta % 60);
+        out << buf;
+    }
+
+    if(_counters.size() > 1){
+        size_t minCount = _counters.front().get();
+        size_t maxCount = minCount;
+        for(const auto& counter : _counters){
+            minCount = std::min(minCount, counter.get());
+            maxCount = std::max(maxCount, counter.get());
+        }
+        out << " (per thread " << minCount << '-' << maxCount << ')';
+    }
+    out << "    ";
+}
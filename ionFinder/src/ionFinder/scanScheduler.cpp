@@ -0,0 +1,205 @@
+//
+// scanScheduler.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <ionFinder/scanScheduler.hpp>
+
+/**
+ * Split \p nScans into batches and deal them out to \p nWorkers queues.
+ * \param nScans Total number of scans to schedule.
+ * \param nWorkers Number of worker threads.
+ * \param batchSize Number of scans in each batch. If 0, a batch size is calculated with calcBatchSize.
+ */
+IonFinder::ScanScheduler::ScanScheduler(size_t nScans, unsigned int nWorkers, size_t batchSize)
+{
+    if(nWorkers == 0) nWorkers = 1;
+    if(batchSize == 0)
+        batchSize = calcBatchSize(nScans, nWorkers);
+
+    for(size_t i = 0; i < nScans; i += batchSize)
+        _batches.emplace_back(i, std::min(i + batchSize, nScans));
+
+    initQueues(nWorkers);
+}
+
+/**
+ * Construct scheduler in file affinity mode. <br><br>
+ * Scans are grouped into one batch for each unique MS file. Batches are assigned
+ * largest first to the worker with the fewest scans assigned so far.
+ * \param scanFiles MS file for each scan in the input scan list.
+ * \param nWorkers Number of worker threads.
+ */
+IonFinder::ScanScheduler::ScanScheduler(const std::vector<std::string>& scanFiles, unsigned int nWorkers)
+{
+    if(nWorkers == 0) nWorkers = 1;
+
+    // group scan indices by file in order of first appearance
+    std::map<std::string, size_t> fileIndex;
+    for(size_t i = 0; i < scanFiles.size(); i++){
+        auto it = fileIndex.find(scanFiles[i]);
+        if(it == fileIndex.end()){
+            it = fileIndex.emplace(scanFiles[i], _batches.size()).first;
+            _batches.emplace_back(scanFiles[i], std::vector<size_t>());
+        }
+        _batches[it->second].indices.push_back(i);
+    }
+
+    for(unsigned int i = 0; i < nWorkers; i++)
+        _queues.emplace_back(new WorkerQueue());
+
+    // Largest batches first, to the least loaded worker.
+    std::vector<size_t> order(_batches.size());
+    for(size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) -> bool {
+        return _batches[lhs].size() > _batches[rhs].size();
+    });
+    std::vector<size_t> load(nWorkers, 0);
+    for(auto b : order){
+        auto w = size_t(std::min_element(load.begin(), load.end()) - load.begin());
+        _queues[w]->batches.push_back(b);
+        load[w] += _batches[b].size();
+    }
+}
+
+/**
+ * Initialize a queue for each worker and give each worker a contiguous block of batches
+ * so that workers initially process scans from the same region of the input.
+ * \param nWorkers Number of worker threads.
+ */
+void IonFinder::ScanScheduler::initQueues(unsigned int nWorkers)
+{
+    for(unsigned int i = 0; i < nWorkers; i++)
+        _queues.emplace_back(new WorkerQueue());
+
+    size_t nBatches = _batches.size();
+    size_t perWorker = nBatches / nWorkers;
+    size_t remainder = nBatches % nWorkers;
+    size_t batchIndex = 0;
+    for(unsigned int w = 0; w < nWorkers; w++){
+        size_t n = perWorker + (w < remainder ? 1 : 0);
+        for(size_t i = 0; i < n; i++)
+            _queues[w]->batches.push_back(batchIndex++);
+    }
+}
+
+/**
+ * Calculate batch size so each worker initially gets about BATCHES_PER_WORKER batches.
+ * \param nScans Total number of scans.
+ * \param nWorkers Number of worker threads.
+ * \return Number of scans per batch.
+ */
+size_t IonFinder::ScanScheduler::calcBatchSize(size_t nScans, unsigned int nWorkers)
+{
+    size_t ret = nScans / (std::max(nWorkers, 1u) * BATCHES_PER_WORKER);
+    return std::max(MIN_SCAN_BATCH_SIZE, std::min(ret, MAX_SCAN_BATCH_SIZE));
+}
+
+//! Take the next batch from the front of \p worker's own queue.
+bool IonFinder::ScanScheduler::popOwn(unsigned int worker, size_t& batchIndex)
+{
+    WorkerQueue& queue = *_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.batches.empty()) return false;
+    batchIndex = queue.batches.front();
+    queue.batches.pop_front();
+    return true;
+}
+
+/**
+ * Steal a batch from the back of the queue with the most remaining batches.
+ * \param worker Index of the worker stealing.
+ * \param batchIndex Set to the index of the stolen batch.
+ * \return false if there was nothing left to steal.
+ */
+bool IonFinder::ScanScheduler::steal(unsigned int worker, size_t& batchIndex)
+{
+    while(true)
+    {
+        // find victim with the most remaining work
+        size_t maxRemaining = 0;
+        unsigned int victim = worker;
+        unsigned int nWorkers = getNumWorkers();
+        for(unsigned int i = 1; i < nWorkers; i++){
+            unsigned int w = (worker + i) % nWorkers;
+            std::lock_guard<std::mutex> lock(_queues[w]->mutex);
+            if(_queues[w]->batches.size() > maxRemaining){
+                maxRemaining = _queues[w]->batches.size();
+                victim = w;
+            }
+        }
+        if(maxRemaining == 0) return false;
+
+        // The victim's queue could have been emptied since it was inspected, so try again if it was.
+        WorkerQueue& queue = *_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.batches.empty()) continue;
+        batchIndex = queue.batches.back();
+        queue.batches.pop_back();
+        return true;
+    }
+}
+
+/**
+ * Get the next batch for \p worker. This function is thread safe.
+ * \param worker Index of worker requesting a batch.
+ * \param batchIndex Set to the index of the next batch.
+ * \param stolen Set to true if the batch was stolen from another worker.
+ * \return false if all batches have been handed out.
+ */
+bool IonFinder::ScanScheduler::next(unsigned int worker, size_t& batchIndex, bool& stolen)
+{
+    stolen = false;
+    if(popOwn(worker, batchIndex)) return true;
+    stolen = steal(worker, batchIndex);
+    return stolen;
+}
+
+/**
+ * Estimate the order batches will be started in if all workers progress at the same rate.
+ * Batches are taken round robin from the front of each worker's queue.
+ * Should be called before any workers are started.
+ * \return Indices of batches in projected order.
+ */
+std::vector<size_t> IonFinder::ScanScheduler::projectedOrder() const
+{
+    std::vector<std::deque<size_t> > queues;
+    size_t maxLen = 0;
+    for(const auto& queue : _queues){
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queues.push_back(queue->batches);
+        maxLen = std::max(maxLen, queue->batches.size());
+    }
+
+    std::vector<size_t> ret;
+    ret.reserve(_batches.size());
+    for(size_t i = 0; i < maxLen; i++){
+        for(const auto& queue : queues){
+            if(i < queue.size())
+                ret.push_back(queue[i]);
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,235 @@
+//
+// stream.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <ionFinder/stream.hpp>
+
+/**
+ * \param pars Initialized IonFinder::Params object.
+ * \param pool Thread pool to run the labeling stage on. One labeling task is run on each worker.
+ */
+IonFinder::StreamPipeline::StreamPipeline(const IonFinder::Params& pars, ThreadPool& pool)
+    : _pars(pars),
+      _pool(pool),
+      _nThread(pool.size()),
+      _labelQueue(STREAM_QUEUE_SIZE),
+      _analyzeQueue(STREAM_QUEUE_SIZE),
+      _writeQueue(STREAM_QUEUE_SIZE),
+      _msInterface(pars.getReaderOptions()),
+      _ladderCache(pars.getLadderCacheSize()),
+      _aadbCache(pars),
+      _labelThreadsRunning(0)
+{
+    _progress = nullptr;
+    _window = STREAM_WINDOW_PER_THREAD * _nThread;
+    _addModResidues = !pars.getFastaFile().empty();
+    _nSeqNotFound = 0;
+    _nRead = 0;
+    _nWritten = 0;
+    _failed = false;
+}
+
+/**
+ * Run the pipeline and write results to Params::makeOfname().
+ * \return true if all PSMs were processed and written successfully.
+ */
+bool IonFinder::StreamPipeline::run()
+{
+    if(_addModResidues){
+        std::cout << "\nReading FASTA file...";
+        if(!_seqFile.read(_pars.getFastaFile())) return false;
+        std::cout << "Done!" << NEW_LINE;
+    }
+
+    std::ofstream outF(_pars.makeOfname());
+    if(!outF) return false;
+    printPeptideStatsHeader(outF, _pars);
+
+    ProgressReporter progress("\nStreaming PSMs from input files to output using " + std::to_string(_nThread) + " thread(s)...",
+                              0, 1, !_pars.getVerbose());
+    _progress = &progress.getCounter(0);
+    progress.start();
+
+    std::vector<std::thread> threads;
+    std::vector<std::future<void> > labelers;
+    _labelThreadsRunning = _nThread;
+    threads.emplace_back(&StreamPipeline::readStage, this);
+    for(unsigned int i = 0; i < _nThread; i++)
+        labelers.push_back(_pool.submit(std::bind(&StreamPipeline::labelStage, this)));
+    threads.emplace_back(&StreamPipeline::analyzeStage, this);
+    threads.emplace_back(&StreamPipeline::writeStage, this, std::ref(outF));
+    // labelStage catches its own exceptions, so the futures are only waited on
+    for(auto& labeler : labelers)
+        labeler.wait();
+    for(auto& thread : threads)
+        thread.join();
+    progress.finish();
+    _progress = nullptr;
+
+    if(_failed){
+        std::cerr << NEW_LINE << _error << NEW_LINE;
+        return false;
+    }
+    if(_nSeqNotFound > 0){
+        std::cerr << NEW_LINE << _nSeqNotFound << " protein sequences not found in " <<
+        _pars.getFastaFile() << NEW_LINE;
+    }
+    return bool(outF);
+}
+
+/**
+ * Stop all stages. Only the first error message is kept.
+ * \param message Error message to print.
+ */
+void IonFinder::StreamPipeline::fail(const std::string& message)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!_failed) _error = message;
+        _failed = true;
+    }
+    cv.notify_all();
+    _labelQueue.cancel();
+    _analyzeQueue.cancel();
+    _writeQueue.cancel();
+}
+
+/**
+ * Parse input files, waiting whenever the maximum number of PSMs are in the pipeline.
+ * Each PSM is registered with the MsInterface as it is read.
+ */
+void IonFinder::StreamPipeline::readStage()
+{
+    bool success = IonFinder::readInputFiles(_pars, [this](Dtafilter::Scan& scan) -> bool {
+        ItemPtr item(new StreamItem());
+        item->scan = scan;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() -> bool { return _failed || _nRead - _nWritten < _window; });
+            if(_failed) return false;
+            item->index = _nRead++;
+        }
+        // registered before labeling so the file is not released while PSMs from it are in the pipeline
+        _msInterface.addNeededScan(item->scan);
+        return _labelQueue.push(std::move(item));
+    });
+
+    if(success){
+        _labelQueue.close();
+        return;
+    }
+
+    // reading also stops if another stage failed
+    bool otherFailed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        otherFailed = _failed;
+    }
+    if(!otherFailed) fail("Failed to read input files!");
+}
+
+//! Get and label the spectrum for each PSM.
+void IonFinder::StreamPipeline::labelStage()
+{
+    std::string curSample;
+    const aaDB::AADB* aminoAcidMasses = nullptr;
+    ms2::Spectrum spectrum;
+    ItemPtr item;
+
+    try{
+        while(_labelQueue.pop(item))
+        {
+            if(aminoAcidMasses == nullptr || (_pars.getInputMode() == DTAFILTER_INPUT_STR && curSample != item->scan.getSampleName()))
+                aminoAcidMasses = &_aadbCache.get(item->scan);
+            curSample = item->scan.getSampleName();
+
+            item->peptide = PeptideNamespace::Peptide(item->scan.getSequence());
+            IonFinder::labelScan(item->scan, _msInterface, _ladderCache, *aminoAcidMasses, item->peptide, spectrum, _pars);
+            // the file is removed once no PSMs from it are left in the pipeline
+            _msInterface.release(item->scan.getPrecursor().getFile());
+            if(!_analyzeQueue.push(std::move(item))) break;
+        }
+    } catch(std::exception& e){
+        fail(e.what());
+    }
+
+    // the last labeling thread to finish closes the next queue
+    if(--_labelThreadsRunning == 0)
+        _analyzeQueue.close();
+}
+
+//! Analyze each labeled peptide and free its fragments.
+void IonFinder::StreamPipeline::analyzeStage()
+{
+    ItemPtr item;
+    try{
+        while(_analyzeQueue.pop(item))
+        {
+            IonFinder::analyzePeptide(item->scan, item->peptide, _addModResidues ? &_seqFile : nullptr,
+                                      _pars, item->stats, _nSeqNotFound);
+            item->peptide = PeptideNamespace::Peptide();
+            if(!_writeQueue.push(std::move(item))) break;
+        }
+    } catch(std::exception& e){
+        fail(e.what());
+    }
+    _writeQueue.close();
+}
+
+/**
+ * Write rows for each PSM in input order.
+ * PSMs which finish out of order are held until all PSMs before them have been written.
+ * \param out Stream to write to.
+ */
+void IonFinder::StreamPipeline::writeStage(std::ostream& out)
+{
+    std::vector<PeptideStats::IonType> ionTypes = printedIonTypes(_pars);
+    std::map<size_t, ItemPtr> pending;
+    TextBuffer buffer;
+    size_t next = 0;
+    ItemPtr item;
+
+    while(_writeQueue.pop(item))
+    {
+        size_t index = item->index;
+        pending[index] = std::move(item);
+        auto it = pending.begin();
+        if(it->first != next) continue;
+        for(; it != pending.end() && it->first == next; it = pending.erase(it), next++){
+            for(const auto& stat : it->second->stats)
+                printPeptideStatsRow(buffer, stat, ionTypes, _pars);
+            ++(*_progress);
+        }
+        buffer.write(out);
+        buffer.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            _nWritten = next;
+        }
+        cv.notify_all();
+    }
+    if(!out) fail("Failed to write peptide stats!");
+}
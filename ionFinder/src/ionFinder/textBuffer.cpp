@@ -0,0 +1,68 @@
+//
+// textBuffer.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <ionFinder/textBuffer.hpp>
+
+void IonFinder::TextBuffer::appendUnsigned(unsigned long long value)
+{
+    char buf[24];
+    char* const end = buf + sizeof(buf);
+    char* p = end;
+    do{
+        *--p = char('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
+    _buffer.append(p, size_t(end - p));
+}
+
+void IonFinder::TextBuffer::appendSigned(long long value)
+{
+    if(value < 0){
+        _buffer.push_back('-');
+        appendUnsigned(0ULL - (unsigned long long)value);
+    }
+    else appendUnsigned((unsigned long long)value);
+}
+
+//! Format \p value the same way as a std::ostream with default precision and flags.
+void IonFinder::TextBuffer::appendDouble(double value)
+{
+    char buf[32];
+    int len = std::snprintf(buf, sizeof(buf), "%g", value);
+    if(len > 0) _buffer.append(buf, size_t(len));
+}
+
+/**
+ * Write buffer to \p out in a single block.
+ * \param out Stream to write to.
+ * \return true if write was successful.
+ */
+bool IonFinder::TextBuffer::write(std::ostream& out) const
+{
+    out.write(_buffer.data(), std::streamsize(_buffer.size()));
+    return bool(out);
+}
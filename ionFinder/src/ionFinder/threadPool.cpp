@@ -0,0 +1,128 @@
+//
+// threadPool.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <ionFinder/threadPool.hpp>
+
+thread_local const IonFinder::ThreadPool* IonFinder::ThreadPool::_currentPool = nullptr;
+thread_local unsigned int IonFinder::ThreadPool::_currentIndex = 0;
+
+/**
+ * Start \p nThread worker threads.
+ * \param nThread Number of workers. At least one worker is always started.
+ */
+IonFinder::ThreadPool::ThreadPool(unsigned int nThread)
+{
+    _stop = false;
+    nThread = std::max(nThread, 1u);
+    for(unsigned int i = 0; i < nThread; i++)
+        _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+//! Finish all submitted tasks and join workers.
+IonFinder::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        _stop = true;
+    }
+    cv.notify_all();
+    for(auto& worker : _workers)
+        worker.join();
+}
+
+void IonFinder::ThreadPool::workerLoop(unsigned int index)
+{
+    _currentPool = this;
+    _currentIndex = index;
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() -> bool { return _stop || !_tasks.empty(); });
+            if(_tasks.empty()) return;
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
+
+/**
+ * Call \p fn on consecutive chunks of [\p begin, \p end) in parallel and wait for all chunks to finish. <br>
+ * Chunks are handed out in order to the pool workers and the calling thread.
+ * If any call to \p fn throws, the first exception is rethrown after all chunks have finished.
+ * \param begin Start of range.
+ * \param end End of range.
+ * \param chunkSize Number of elements in each chunk. If 0, the range is split into about
+ * CHUNKS_PER_THREAD chunks for each thread.
+ * \param fn Function called with the [begin, end) of each chunk.
+ */
+void IonFinder::ThreadPool::parallelFor(size_t begin, size_t end, size_t chunkSize,
+                                        const std::function<void(size_t, size_t)>& fn)
+{
+    if(begin >= end) return;
+    size_t const len = end - begin;
+    if(chunkSize == 0)
+        chunkSize = std::max<size_t>(1, len / ((size() + 1) * CHUNKS_PER_THREAD));
+    size_t const nChunks = (len + chunkSize - 1) / chunkSize;
+
+    std::atomic<size_t> nextChunk(0);
+    auto runner = [&](){
+        size_t chunk;
+        while((chunk = nextChunk++) < nChunks){
+            size_t chunkBegin = begin + chunk * chunkSize;
+            fn(chunkBegin, std::min(end, chunkBegin + chunkSize));
+        }
+    };
+
+    // Nested calls run inline. Waiting on other workers from inside a worker could deadlock.
+    if(nChunks == 1 || inWorker()){
+        runner();
+        return;
+    }
+
+    std::vector<std::future<void> > futures;
+    size_t nRunners = std::min<size_t>(nChunks - 1, size());
+    for(size_t i = 0; i < nRunners; i++)
+        futures.push_back(submit(runner));
+
+    std::exception_ptr error;
+    try{
+        runner();
+    } catch(...){
+        error = std::current_exception();
+    }
+    for(auto& future : futures){
+        try{
+            future.get();
+        } catch(...){
+            if(!error) error = std::current_exception();
+        }
+    }
+    if(error) std::rethrow_exception(error);
+}
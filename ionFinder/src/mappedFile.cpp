@@ -0,0 +1,113 @@
+//
+// mappedFile.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <mappedFile.hpp>
+
+/**
+ * Map \p fname into memory. Any file which is already mapped is closed first.
+ * @param fname Path to file.
+ * @return true if successful.
+ */
+bool ms2::MappedFile::open(const std::string& fname)
+{
+    close();
+#ifndef _WIN32
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat buffer;
+    if(fstat(fd, &buffer) != 0) {
+        ::close(fd);
+        return false;
+    }
+    _size = (size_t)buffer.st_size;
+
+    //mmap of an empty file fails, but there is nothing to read anyway
+    if(_size == 0) {
+        ::close(fd);
+        _data = "";
+        return true;
+    }
+
+    void* map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(map == MAP_FAILED) {
+        _size = 0;
+        return false;
+    }
+    _data = (const char*)map;
+#else
+    std::ifstream inF(fname, std::ios::binary | std::ios::ate);
+    if(!inF) return false;
+    _size = (size_t)inF.tellg();
+    _buffer.resize(_size + 1);
+    inF.seekg(0);
+    if(!inF.read(_buffer.data(), (std::streamsize)_size)) {
+        _buffer.clear();
+        _size = 0;
+        return false;
+    }
+    _data = _buffer.data();
+#endif
+    return true;
+}
+
+//! Unmap the file.
+void ms2::MappedFile::close()
+{
+#ifndef _WIN32
+    if(_data != nullptr && _size > 0)
+        munmap((void*)_data, _size);
+#else
+    std::vector<char>().swap(_buffer);
+#endif
+    _data = nullptr;
+    _size = 0;
+}
+
+/**
+ * Tell the kernel how the mapping will be accessed.
+ * DONT_NEED releases resident pages, which are read from disk again if they are accessed later.
+ * @param advice Access pattern.
+ */
+void ms2::MappedFile::advise(Advice advice) const
+{
+#ifndef _WIN32
+    if(_data == nullptr || _size == 0) return;
+    int flag = MADV_NORMAL;
+    switch(advice) {
+        case Advice::SEQUENTIAL: flag = MADV_SEQUENTIAL;
+            break;
+        case Advice::RANDOM: flag = MADV_RANDOM;
+            break;
+        case Advice::DONT_NEED: flag = MADV_DONTNEED;
+            break;
+    }
+    madvise((void*)_data, _size, flag);
+#else
+    (void)advice;
+#endif
+}
@@ -0,0 +1,73 @@
+//
+// mappedMs2File.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <mappedMs2File.hpp>
+
+/**
+ * Map \p fname and find the position of each scan.
+ * @param fname Path to .ms2 file.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::MappedMs2File::read(const std::string& fname)
+{
+    _fname = fname;
+    if(!_file.open(fname)) return false;
+    if(_useSidecar ? !_index.load(fname) : !_index.build(fname))
+        return false;
+
+    //scans are requested in no particular order
+    _file.advise(MappedFile::Advice::RANDOM);
+    return true;
+}
+
+/**
+ * Parse a single scan from the mapped file.
+ * This function is thread safe.
+ * @param scanNum Scan number to retrieve.
+ * @param scan Spectrum to populate.
+ * @return true if the scan was found.
+ */
+bool ms2::MappedMs2File::getScan(size_t scanNum, ms2::Spectrum& scan) const
+{
+    const ScanIndex::Entry* entry = _index.find(scanNum);
+    if(!entry || entry->offset + entry->length > _file.size()) return false;
+
+    PrecursorScan precursor;
+    precursor.setFile(_fname);
+    precursor.setMZ(entry->precursorMZ);
+    precursor.setRT(entry->rt);
+    precursor.setCharge(entry->charge);
+
+    std::vector<ScanIon> ions;
+    const char* begin = _file.data() + entry->offset;
+    if(!IndexedMsFile::parseMs2(begin, begin + entry->length, precursor, ions))
+        return false;
+    _peakFilter.apply(ions);
+
+    scan.assign(scanNum, precursor, ions);
+    return true;
+}
@@ -35,6 +35,7 @@ ms2::DataPoint& ms2::DataPoint::operator = (const ms2::DataPoint& rhs)
     topAbundant = rhs.topAbundant;
     ionType = rhs.ionType;
     ionNum = rhs.ionNum;
+    _fragment = rhs._fragment;
     _ion = rhs._ion;
     _noise = rhs._noise;
     _snr = rhs._snr;
@@ -49,6 +50,7 @@ ms2::DataPoint::DataPoint(const ms2::DataPoint& rhs)
     topAbundant = rhs.topAbundant;
     ionType = rhs.ionType;
     ionNum = rhs.ionNum;
+    _fragment = rhs._fragment;
     _ion = rhs._ion;
     _noise = rhs._noise;
     _snr = rhs._snr;
@@ -167,6 +169,34 @@ void ms2::Spectrum::clear()
     utils::msInterface::Scan::clear();
 }
 
+/**
+ * Replace the contents of the Spectrum with a scan read outside of peptideUtils.
+ * \param scanNum Scan number.
+ * \param precursor Precursor data.
+ * \param ions Ions in scan. The contents of \p ions are moved into the Spectrum.
+ */
+void ms2::Spectrum::assign(size_t scanNum, const utils::msInterface::PrecursorScan& precursor,
+                           std::vector<utils::msInterface::ScanIon>& ions)
+{
+    clear();
+    setScanNum(scanNum);
+    precursorScan = precursor;
+    _ions.swap(ions);
+    updateRanges();
+}
+
+/**
+ * Remove ions with \p filter.
+ * Labeled ions are cleared because they point to elements of utils::Scan::_ions.
+ * \param filter Peak filter to apply.
+ */
+void ms2::Spectrum::filterIons(const PeakFilter& filter)
+{
+    _dataPoints.clear();
+    filter.apply(_ions);
+    updateRanges();
+}
+
 /**
  * Set the DataPoint::topAbundant value for the top n ion intensities.<br><br>
  *
@@ -414,7 +444,8 @@ void ms2::Spectrum::labelSpectrum(PeptideNamespace::Peptide& peptide,
                 std::cout << "In sequence: " << peptide.getFullSequence() << NEW_LINE;
                 seqPrinted = true;
             }
-            std::cout << "\tDuplicate label found: " << (*label)->getLabel() << ", " <<
+            std::cout << "\tDuplicate label found: " <<
+                      ((*label)->_fragment == std::string::npos ? (*label)->getLabel() : peptide.getFragmentLabel((*label)->_fragment)) << ", " <<
                       peptide.getFragmentLabel(i) << NEW_LINE;
         }
 
@@ -423,8 +454,7 @@ void ms2::Spectrum::labelSpectrum(PeptideNamespace::Peptide& peptide,
         {
             if(peptide.getIncludeLabel(i)) //only label spectrum if fragment should be labeled.
             {
-                (*label)->setLabel(peptide.getFragmentLabel(i));
-                (*label)->setFormatedLabel(peptide.getFormatedLabel(i));
+                (*label)->_fragment = i; //label strings are only made if the spectrum is printed
                 (*label)->setLabeledIon(true);
                 (*label)->label.setIncludeLabel(true);
                 (*label)->setIonType(peptide.getFragment(i).getIonType());
@@ -444,11 +474,29 @@ void ms2::Spectrum::labelSpectrum(PeptideNamespace::Peptide& peptide,
 
     //remove unlabeled peptide fragments
     //only used for debugging
-    if(removeUnlabeledFrags)
+    if(removeUnlabeledFrags){
+        makeLabels(peptide);
         peptide.removeUnlabeledFrags();
+    }
 
 }//end of function
 
+/**
+ * Make label strings for ions labeled by labelSpectrum. <br>
+ * Must be called with the same \p peptide before the spectrum is printed
+ * or label positions are calculated.
+ * \param peptide Peptide the spectrum was labeled with.
+ */
+void ms2::Spectrum::makeLabels(const PeptideNamespace::Peptide& peptide)
+{
+    for(auto& ion : _dataPoints){
+        if(ion._fragment == std::string::npos) continue;
+        ion.setLabel(peptide.getFragmentLabel(ion._fragment));
+        ion.setFormatedLabel(peptide.getFormatedLabel(ion._fragment));
+        ion._fragment = std::string::npos;
+    }
+}
+
 void ms2::Spectrum::makePoints(labels::Labels& labs, double maxPerc,
                                double offset_x, double offset_y,
                                double x_padding, double y_padding)
@@ -27,41 +27,349 @@
 
 #include <msInterface.hpp>
 
+ms2::MsInterface::~MsInterface()
+{
+    delete _files.load();
+    for(auto it = _retired.begin(); it != _retired.end(); ++it)
+        delete *it;
+}
+
 /**
- * Read an individual MS file. If the file has already been read, the file will simply return true.
- * This function is thread safe.
+ * Lock free lookup of the registry entry for \p fname.
+ * @param fname Path to MS file.
+ * @return Entry for \p fname or nullptr if \p fname is not in the registry.
+ */
+std::shared_ptr<ms2::MsInterface::FileEntry> ms2::MsInterface::findEntry(const std::string& fname) const
+{
+    // Announce the read before loading the snapshot so writers will not free it while it is in use.
+    _readers.fetch_add(1);
+    const FileMap* files = _files.load();
+    auto it = files->find(fname);
+    std::shared_ptr<FileEntry> ret = it == files->end() ? nullptr : it->second;
+    _readers.fetch_sub(1);
+    return ret;
+}
+
+/**
+ * Get the registry entry for \p fname, adding an empty entry if one does not already exist.
+ * @param fname Path to MS file.
+ * @return Entry for \p fname.
+ */
+std::shared_ptr<ms2::MsInterface::FileEntry> ms2::MsInterface::insertEntry(const std::string& fname)
+{
+    std::lock_guard<std::mutex> lock (writeMutex);
+    const FileMap* files = _files.load();
+    auto it = files->find(fname);
+    if(it != files->end()) return it->second;
+
+    FileMap* newFiles = new FileMap(*files);
+    auto entry = std::make_shared<FileEntry>();
+    (*newFiles)[fname] = entry;
+    publish(newFiles);
+    return entry;
+}
+
+/**
+ * Replace the current snapshot of the file map with \p files.
+ * The old snapshot is retired and freed once no readers are active.
+ * writeMutex must be held by the caller.
+ * @param files New snapshot. MsInterface takes ownership of the pointer.
+ */
+void ms2::MsInterface::publish(const FileMap* files)
+{
+    _retired.push_back(_files.exchange(files));
+    if(_readers.load() == 0){
+        for(auto it = _retired.begin(); it != _retired.end(); ++it)
+            delete *it;
+        _retired.clear();
+    }
+}
+
+/**
+ * Parse \p fname and store the result in \p entry.
+ * If \p fname does not exist but a gzip compressed copy does, the compressed copy is read.
+ * Memory for the file is reserved before it is read, which blocks if the memory budget is full,
+ * unless the caller already reserved it.
+ * Should only be called through std::call_once on \p entry.loaded.
  * @param fname Path to file to read.
+ * @param entry Registry entry for \p fname.
+ * @param reserved Bytes the caller already charged to the memory budget for \p fname, or 0.
  * @return true if all file I/O was successful.
  */
-bool ms2::MsInterface::read(std::string fname)
+bool ms2::MsInterface::loadFile(const std::string& fname, FileEntry& entry, size_t reserved)
 {
-    // Check if file already exists and exit if it does.
-    if(_ms2Map.find(fname) != _ms2Map.end()) return true;
-
-    auto _file = std::shared_ptr<utils::msInterface::MsInterface>();
-    utils::msInterface::MsInterface::FileType fileType = utils::msInterface::MsInterface::getFileType(fname);
-    if(fileType == utils::msInterface::MsInterface::FileType::MS2)
-        _file = std::make_shared<utils::msInterface::Ms2File>();
-    else if(fileType == utils::msInterface::MsInterface::FileType::MZXML)
-        _file = std::make_shared<utils::msInterface::MzXMLFile>();
-    else if(fileType == utils::msInterface::MsInterface::FileType::MZML)
-        _file = std::make_shared<utils::msInterface::MzMLFile>();
-    else {
-        std::cerr << "Unknown file type for file " << fname << NEW_LINE;
-        return false;
-    }
-    if(!_file->read(fname)) {
+    //input files name MS files without the gzip extension
+    std::string const path = gzip::findFile(fname);
+    std::shared_ptr<MsFile> _file = ms2::makeScanSource(path, _options);
+    size_t const estimate = reserved > 0 ? reserved : _file->estimateMemory(path);
+    if(reserved == 0) reserveMemory(fname, estimate);
+
+    std::vector<size_t> scans = getNeededScans(fname);
+    if(!(scans.empty() ? _file->read(path) : _file->read(path, scans))) {
+        releaseMemory(estimate);
         std::cerr << "\n\tFailed to read: " << fname << NEW_LINE;
         std::cerr << "\t\tNo file found at: " << utils::absPath(fname) << NEW_LINE;
         return false;
     }
 
-    // lock mutex
-    std::lock_guard<std::mutex> lock (mutex);
-    _ms2Map[fname] = _file;
+    // replace the estimate with the actual memory used
+    size_t const used = _file->memoryUsage();
+    {
+        std::lock_guard<std::mutex> lock (memoryMutex);
+        _memoryUsed = _memoryUsed - estimate + used;
+    }
+    if(used < estimate) memoryCv.notify_all();
+    // lastUsed is set when the file is handed to the thread which loaded it, so it can not be evicted before then
+    entry.memory.store(used);
+
+    std::atomic_store(&entry.file, _file);
+    entry.success = true;
+    return true;
+}
+
+/**
+ * Charge \p bytes to the memory budget.
+ * If there is not room for \p bytes, idle files are evicted until there is.
+ * If nothing can be evicted the function waits for files to be released.
+ * A file is always allowed to load when nothing else is in memory so a single
+ * file larger than the budget can not block forever.
+ * @param fname File memory is being reserved for. It is never evicted.
+ * @param bytes Bytes to reserve.
+ */
+void ms2::MsInterface::reserveMemory(const std::string& fname, size_t bytes)
+{
+    std::unique_lock<std::mutex> lock (memoryMutex);
+    if(_options.maxMemory > 0) {
+        while(_memoryUsed > 0 && _memoryUsed + bytes > _options.maxMemory) {
+            lock.unlock();
+            bool evicted = evictIdle(fname);
+            lock.lock();
+            if(!evicted)
+                memoryCv.wait_for(lock, std::chrono::milliseconds(100));
+        }
+    }
+    _memoryUsed += bytes;
+}
+
+/**
+ * Charge \p bytes to the memory budget only if they fit. Nothing is evicted and the function does not wait.
+ * @param bytes Bytes to reserve.
+ * @return true if the bytes were reserved.
+ */
+bool ms2::MsInterface::tryReserveMemory(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock (memoryMutex);
+    if(_options.maxMemory > 0 && _memoryUsed > 0 && _memoryUsed + bytes > _options.maxMemory)
+        return false;
+    _memoryUsed += bytes;
+    return true;
+}
+
+//! Return \p bytes to the memory budget and wake threads waiting for memory.
+void ms2::MsInterface::releaseMemory(size_t bytes)
+{
+    if(bytes == 0) return;
+    {
+        std::lock_guard<std::mutex> lock (memoryMutex);
+        _memoryUsed -= std::min(bytes, _memoryUsed);
+    }
+    memoryCv.notify_all();
+}
+
+/**
+ * Remove the least recently used file which no thread is reading from.
+ * Files with no unreleased PSMs are evicted first.
+ * @param exclude File which should not be evicted.
+ * @return true if a file was evicted.
+ */
+bool ms2::MsInterface::evictIdle(const std::string& exclude)
+{
+    std::string victim;
+    bool victimFinished = false;
+    uint64_t victimLastUsed = 0;
+
+    _readers.fetch_add(1);
+    const FileMap* files = _files.load();
+    for(const auto& it : *files) {
+        if(it.first == exclude) continue;
+        std::shared_ptr<MsFile> file = std::atomic_load(&it.second->file);
+        // the entry and the local copy are the only owners if no one is reading the file
+        if(!file || file.use_count() > 2) continue;
+        // loaded but not yet used by the thread which loaded it
+        uint64_t lastUsed = it.second->lastUsed.load();
+        if(lastUsed == 0) continue;
+
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock (neededScansMutex);
+            auto remaining = _remaining.find(it.first);
+            finished = remaining == _remaining.end() || remaining->second == 0;
+        }
+        if(victim.empty() || (finished && !victimFinished) ||
+           (finished == victimFinished && lastUsed < victimLastUsed)) {
+            victim = it.first;
+            victimFinished = finished;
+            victimLastUsed = lastUsed;
+        }
+    }
+    _readers.fetch_sub(1);
+
+    if(victim.empty()) return false;
+    remove(victim);
     return true;
 }
 
+/**
+ * Record which scans will be requested from each file between \p begin and \p end.
+ * When a file is read, the list of scans is passed to its ScanSource so readers which
+ * support it only decode the scans which are needed.
+ * This function is thread safe, but it only affects files which have not been read yet.
+ * @param begin Starting iterator
+ * @param end Ending iterator
+ */
+void ms2::MsInterface::addNeededScans(InputScanList::const_iterator begin, InputScanList::const_iterator end)
+{
+    std::lock_guard<std::mutex> lock (neededScansMutex);
+    std::set<std::string> modified;
+    for(auto it = begin; it != end; ++it) {
+        const std::string& fname = it->getPrecursor().getFile();
+        _neededScans[fname].push_back(it->getScanNum());
+        _remaining[fname]++;
+        modified.insert(fname);
+    }
+    for(const auto& fname : modified) {
+        std::vector<size_t>& scans = _neededScans[fname];
+        std::sort(scans.begin(), scans.end());
+        scans.erase(std::unique(scans.begin(), scans.end()), scans.end());
+    }
+}
+
+/**
+ * Record that \p scan will be requested. Used when PSMs are registered one at a time as they are read.
+ * This function is thread safe, but it only affects files which have not been read yet.
+ * @param scan PSM which will be searched.
+ */
+void ms2::MsInterface::addNeededScan(const Dtafilter::Scan& scan)
+{
+    std::lock_guard<std::mutex> lock (neededScansMutex);
+    const std::string& fname = scan.getPrecursor().getFile();
+    std::vector<size_t>& scans = _neededScans[fname];
+    auto it = std::lower_bound(scans.begin(), scans.end(), scan.getScanNum());
+    if(it == scans.end() || *it != scan.getScanNum())
+        scans.insert(it, scan.getScanNum());
+    _remaining[fname]++;
+}
+
+//! Get a copy of the scans which will be requested from \p fname.
+std::vector<size_t> ms2::MsInterface::getNeededScans(const std::string& fname) const
+{
+    std::lock_guard<std::mutex> lock (neededScansMutex);
+    auto it = _neededScans.find(fname);
+    return it == _neededScans.end() ? std::vector<size_t>() : it->second;
+}
+
+/**
+ * Get a parsed MS file, reading it if necessary.
+ * If several threads request the same file which has not been read, only one reads it and the rest wait.
+ * @param fname Path to MS file.
+ * @param reserved Bytes the caller already charged to the memory budget for \p fname.
+ * They are used if this thread reads the file and are returned to the budget otherwise.
+ * @return Parsed file or nullptr if the file could not be read.
+ */
+std::shared_ptr<ms2::MsInterface::MsFile> ms2::MsInterface::getFile(const std::string& fname, size_t reserved)
+{
+    while(true){
+        std::shared_ptr<FileEntry> entry = findEntry(fname);
+        if(!entry) entry = insertEntry(fname);
+
+        bool loaded = false;
+        std::call_once(entry->loaded, [this, &fname, &entry, &loaded, reserved](){
+            loadFile(fname, *entry, reserved);
+            loaded = true;
+        });
+        if(!loaded) releaseMemory(reserved);
+        reserved = 0;
+
+        // The entry was removed while we were using it. Look it up again.
+        if(entry->removed.load()) continue;
+        if(!entry->success) return nullptr;
+        std::shared_ptr<MsFile> file = std::atomic_load(&entry->file);
+        if(file) {
+            entry->lastUsed.store(++_useClock);
+            return file;
+        }
+    }
+}
+
+/**
+ * Have all PSMs registered for \p fname with addNeededScans been released?
+ * @param fname MS file name.
+ * @return false if \p fname has no registered PSMs.
+ */
+bool ms2::MsInterface::finished(const std::string& fname) const
+{
+    std::lock_guard<std::mutex> lock (neededScansMutex);
+    auto it = _remaining.find(fname);
+    return it != _remaining.end() && it->second == 0;
+}
+
+/**
+ * Read an individual MS file. If the file has already been read, the file will simply return true.
+ * If another thread is reading the same file, the function waits for it to finish instead of reading
+ * the file again. A file which failed to read is not read again.
+ * Files whose registered PSMs have all been released are not read, because nothing would release them again.
+ * This function is thread safe.
+ * @param fname Path to file to read.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::MsInterface::read(std::string fname)
+{
+    return readFile(fname, 0);
+}
+
+/**
+ * Implementation of read.
+ * @param fname Path to file to read.
+ * @param reserved Bytes the caller already charged to the memory budget for \p fname, or 0.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::MsInterface::readFile(const std::string& fname, size_t reserved)
+{
+    if(finished(fname)) {
+        releaseMemory(reserved);
+        return true;
+    }
+    bool success = getFile(fname, reserved) != nullptr;
+
+    // The last PSM may have been released while the file was loading. Its remove() would have found
+    // nothing to remove, so the copy just loaded is removed here.
+    if(finished(fname)) remove(fname);
+    return success;
+}
+
+/**
+ * Read \p fname ahead of the threads which will search it. <br>
+ * Unlike read, nothing is evicted and the function does not wait for memory.
+ * If the file would not fit in the memory budget it is not read and is left for
+ * the thread which needs it to read. The check and the reservation for the file are made together,
+ * so prefetch threads running at once can not load past the budget.
+ * This function is thread safe.
+ * @param fname Path to file to read.
+ * @return true if the file was read or was already in memory.
+ */
+bool ms2::MsInterface::prefetch(const std::string& fname)
+{
+    std::shared_ptr<FileEntry> entry = findEntry(fname);
+    if(entry && std::atomic_load(&entry->file)) return true;
+
+    if(_options.maxMemory == 0) return read(fname);
+
+    std::string const path = gzip::findFile(fname);
+    size_t const estimate = ms2::makeScanSource(path, _options)->estimateMemory(path);
+    if(!tryReserveMemory(estimate)) return false;
+    return readFile(fname, estimate);
+}
+
 /**
  * Read MS files from a range of Dtafilter::Scan iterators.
  * If a file name occurs more than once, it will only be read once.
@@ -72,6 +380,8 @@ bool ms2::MsInterface::read(std::string fname)
  */
 bool ms2::MsInterface::read(InputScanList::const_iterator begin, InputScanList::const_iterator end)
 {
+    addNeededScans(begin, end);
+
     //first get unique names of ms2 files to read
     std::vector<std::string> fileNamesList;
     ms2::MsInterface::getUniqueFileList(fileNamesList, begin, end);
@@ -80,11 +390,7 @@ bool ms2::MsInterface::read(InputScanList::const_iterator begin, InputScanList::
     bool allSucess = true;
     size_t len = fileNamesList.size();
     for(size_t i = 0; i < len; i++) {
-        std::string _fname = fileNamesList[i];
-        bool fileRead = _ms2Map.find(_fname) == _ms2Map.end();
-        if(fileRead) {
-            if(!read(_fname)) allSucess = false;
-        }
+        if(!read(fileNamesList[i])) allSucess = false;
     }
 
     if(!allSucess){
@@ -104,14 +410,11 @@ bool ms2::MsInterface::read(InputScanList::const_iterator begin, InputScanList::
  * @param scanNum Scan number to retrieve.
  * @return True if parsing scan was successful.
  */
-bool ms2::MsInterface::getScan(utils::msInterface::Scan& scan, std::string fname, size_t scanNum)
+bool ms2::MsInterface::getScan(ms2::Spectrum& scan, std::string fname, size_t scanNum)
 {
-    auto ms2FileIt = _ms2Map.find(fname);
-    if(ms2FileIt == _ms2Map.end()){
-        if(!read(fname)) return false;
-        ms2FileIt = _ms2Map.find(fname);
-    }
-    if(!ms2FileIt->second->getScan(scanNum, scan)){
+    std::shared_ptr<MsFile> file = getFile(fname);
+    if(!file) return false;
+    if(!file->getScan(scanNum, scan)){
         std::cerr << NEW_LINE << "Error reading scan!" << NEW_LINE;
         return false;
     }
@@ -120,26 +423,85 @@ bool ms2::MsInterface::getScan(utils::msInterface::Scan& scan, std::string fname
 
 /**
  * const qualified version of getScan. If \p fname has not been read, the function will return false.
+ * This function is thread safe.
  * @param scan Empty Scan object to populate.
  * @param fname MS file name.
  * @param scanNum Scan number to retrieve.
  * @return True if parsing scan was successful.
  */
-bool ms2::MsInterface::getScan(utils::msInterface::Scan& scan, std::string fname, size_t scanNum) const
+bool ms2::MsInterface::getScan(ms2::Spectrum& scan, std::string fname, size_t scanNum) const
 {
     //load spectrum
-    auto ms2FileIt = _ms2Map.find(fname);
-    if(ms2FileIt == _ms2Map.end()){
+    std::shared_ptr<FileEntry> entry = findEntry(fname);
+    std::shared_ptr<MsFile> file = entry ? std::atomic_load(&entry->file) : nullptr;
+    if(file) entry->lastUsed.store(++_useClock);
+    if(!file){
         std::cerr << NEW_LINE << "Key error in Ms2Map!" << NEW_LINE;
         return false;
     }
-    if(!ms2FileIt->second->getScan(scanNum, scan)){
+    if(!file->getScan(scanNum, scan)){
         std::cerr << NEW_LINE << "Error reading scan!" << NEW_LINE;
         return false;
     }
     return true;
 }
 
+/**
+ * Remove \p fname from the files held in memory. If the file has not been read nothing is done.
+ * Scans can still be retrieved from the file after it is removed, but it will have to be read again.
+ * If the file is being read by another thread, the function waits for the read to finish.
+ * This function is thread safe.
+ * @param fname MS file name.
+ */
+void ms2::MsInterface::remove(const std::string& fname)
+{
+    std::shared_ptr<FileEntry> entry;
+    {
+        std::lock_guard<std::mutex> lock (writeMutex);
+        const FileMap* files = _files.load();
+        auto it = files->find(fname);
+        if(it == files->end()) return;
+        entry = it->second;
+
+        FileMap* newFiles = new FileMap(*files);
+        newFiles->erase(fname);
+        publish(newFiles);
+    }
+
+    // Wait for a read in progress to finish (or stop one from starting) before releasing the file.
+    entry->removed.store(true);
+    std::call_once(entry->loaded, [](){});
+    std::atomic_store(&entry->file, std::shared_ptr<MsFile>());
+    releaseMemory(entry->memory.exchange(0));
+}
+
+/**
+ * Mark \p nScans PSMs from \p fname as processed.
+ * When every PSM registered for \p fname with addNeededScans has been released, the file is removed.
+ * Files with no registered PSMs are not affected.
+ * This function is thread safe.
+ * @param fname MS file name.
+ * @param nScans Number of PSMs processed.
+ */
+void ms2::MsInterface::release(const std::string& fname, size_t nScans)
+{
+    {
+        std::lock_guard<std::mutex> lock (neededScansMutex);
+        auto it = _remaining.find(fname);
+        if(it == _remaining.end() || it->second == 0) return;
+        it->second -= std::min(nScans, it->second);
+        if(it->second > 0) return;
+    }
+    remove(fname);
+}
+
+//! Get the number of bytes currently charged to the memory budget.
+size_t ms2::MsInterface::getMemoryUsed()
+{
+    std::lock_guard<std::mutex> lock (memoryMutex);
+    return _memoryUsed;
+}
+
 //! Get a list of unique file names between \p begin and \p end
 void ms2::MsInterface::getUniqueFileList(std::vector<std::string> &fnames,
                                          std::vector<Dtafilter::Scan>::const_iterator begin,
@@ -0,0 +1,112 @@
+//
+// peakFilter.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <peakFilter.hpp>
+
+namespace {
+    typedef utils::msInterface::ScanIon ScanIon;
+
+    /**
+     * Mark the \p n most intense peaks in [begin, end) of \p order to keep.
+     * Ties are broken by position, the same as a stable sort by intensity.
+     */
+    void markTop(const std::vector<ScanIon>& ions, std::vector<size_t>::iterator begin,
+                 std::vector<size_t>::iterator end, size_t n, std::vector<char>& keep)
+    {
+        if((size_t)(end - begin) > n) {
+            std::stable_sort(begin, end, [&ions](size_t lhs, size_t rhs){
+                return ions[lhs].getIntensity() > ions[rhs].getIntensity();
+            });
+            end = begin + n;
+        }
+        for(auto it = begin; it != end; ++it)
+            keep[*it] = true;
+    }
+
+    //! Remove peaks which are not marked in \p keep without changing the order of the rest.
+    void removeUnmarked(std::vector<ScanIon>& ions, const std::vector<char>& keep)
+    {
+        size_t n = 0;
+        for(size_t i = 0; i < ions.size(); i++)
+            if(keep[i]) ions[n++] = ions[i];
+        ions.resize(n);
+    }
+}
+
+/**
+ * Remove peaks from \p ions in place.
+ * The order of the remaining peaks is not changed.
+ * @param ions Peaks of a scan.
+ */
+void ms2::PeakFilter::apply(std::vector<utils::msInterface::ScanIon>& ions) const
+{
+    if(!active() || ions.empty()) return;
+
+    //intensity floor relative to the most intense peak. Calculated the same way as
+    //Spectrum::normalizeIonInts followed by Spectrum::removeIntensityBelow
+    if(minIntensity > 0) {
+        utils::msInterface::ScanIntensity maxInt = ions.front().getIntensity();
+        for(const auto& ion : ions)
+            maxInt = std::max(maxInt, ion.getIntensity());
+        utils::msInterface::ScanIntensity den = maxInt / 100;
+        ions.erase(std::remove_if(ions.begin(), ions.end(), [this, den](const ScanIon& ion){
+            return ion.getIntensity() / den < minIntensity;
+        }), ions.end());
+    }
+
+    std::vector<size_t> order;
+    std::vector<char> keep;
+
+    //top peaks in each m/z window
+    if(windowTopK > 0 && windowWidth > 0 && ions.size() > windowTopK) {
+        order.resize(ions.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&ions](size_t lhs, size_t rhs){
+            return ions[lhs].getMZ() < ions[rhs].getMZ();
+        });
+        keep.assign(ions.size(), false);
+        auto windowBegin = order.begin();
+        while(windowBegin != order.end()) {
+            double const window = std::floor(ions[*windowBegin].getMZ() / windowWidth);
+            auto windowEnd = windowBegin;
+            while(windowEnd != order.end() && std::floor(ions[*windowEnd].getMZ() / windowWidth) == window)
+                ++windowEnd;
+            markTop(ions, windowBegin, windowEnd, windowTopK, keep);
+            windowBegin = windowEnd;
+        }
+        removeUnmarked(ions, keep);
+    }
+
+    //global top peaks
+    if(topN > 0 && ions.size() > topN) {
+        order.resize(ions.size());
+        std::iota(order.begin(), order.end(), 0);
+        keep.assign(ions.size(), false);
+        markTop(ions, order.begin(), order.end(), topN, keep);
+        removeUnmarked(ions, keep);
+    }
+}
@@ -66,39 +66,17 @@ PeptideNamespace::IonType PeptideNamespace::strToIonType(const std::string& s)
 
 /**
  Get neutral loss as string rounded to nearest integer.
+ \param numNl Multiple of neutral loss.
+ \param nlMass Mass of a single neutral loss.
  \return neutral loss
  */
-std::string PeptideNamespace::FragmentIon::getNLStr() const{
-	return std::string((_nlMass < 1 ? "" : "+")) + std::to_string((int)round(_nlMass));
+std::string PeptideNamespace::makeNLStr(size_t numNl, double nlMass){
+	double totalNl = -1 * (double(numNl) * nlMass);
+	return std::string((totalNl < 1 ? "" : "+")) + std::to_string((int)round(totalNl));
 }
 
-/**
- \brief Given a peptide sequence, initialize the _beg, _end, and _sequence members.
- 
- \param sequence Full peptide sequence.
- */
-void PeptideNamespace::FragmentIon::_initFragSpan(const std::string& sequence)
-{
-	int len = int(sequence.length());
-	
-	if(_b_y == 'b')
-	{
-		_beg = 0;
-		_end = _num - 1;
-	}
-	else if(_b_y == 'y')
-	{
-		_beg = len - _num;
-		_end = len - 1;
-	}
-	else if(_b_y == 'M' || _b_y == 'm')
-	{
-		_beg = 0;
-		_end = len - 1;
-	}
-	else throw std::runtime_error("Unknown IonType!");
-	_sequence = std::string(sequence.begin() + _beg, sequence.begin() + _end + 1);
-	//std::cout << _sequence << std::endl;
+std::string PeptideNamespace::FragmentIon::getNLStr() const{
+	return makeNLStr(getNumNl(), _frags().nlMass);
 }
 
 std::string PeptideNamespace::ionTypeToStr(const PeptideNamespace::IonType& ionType)
@@ -126,6 +104,14 @@ std::string PeptideNamespace::ionTypeToStr(const PeptideNamespace::IonType& ionT
  Get charge label based off sign of Ion::charge.
  */
 std::string PeptideNamespace::Ion::makeChargeLable() const
+{
+	return makeChargeLable(charge);
+}
+
+/**
+ Get charge label based off sign of \p charge.
+ */
+std::string PeptideNamespace::Ion::makeChargeLable(int charge)
 {
 	if(charge > 0)
 		return std::to_string(charge) + "+";
@@ -174,123 +160,283 @@ PeptideNamespace::AminoAcid::AminoAcid(double mass) : Ion() {
 }
 
 /**
- Get ion label.
+ Get fragment ion type as b, y or M.
+ */
+char PeptideNamespace::ionTypeToBY(const PeptideNamespace::IonType& ionType)
+{
+	switch(ionType){
+		case IonType::B :
+		case IonType::B_NL : return 'b';
+		case IonType::Y :
+		case IonType::Y_NL : return 'y';
+		case IonType::M :
+		case IonType::M_NL : return 'M';
+		default:
+			throw std::runtime_error("Unknown ion type!");
+	}
+}
+
+/**
+ Get modification symbols of dynamic modifications on fragment.
+ \return all modifications concated into a single string
+ */
+std::string PeptideNamespace::FragmentIon::getMod() const
+{
+	if(!isModified()) return "";
+	auto begin = _peptide->aminoAcids.begin();
+	return PeptideNamespace::concatMods(begin + getBegin(), begin + getEnd() + 1);
+}
+
+/**
+ Make ion label from packed ion key.
+ \param key Ion to label.
+ \param mod Modification symbols on ion.
+ \param nlMass Mass of a single neutral loss.
+ \param chargeSep Separator between ion and charge.
  \return unformatted ion label
  */
-std::string PeptideNamespace::FragmentIon::getLabel(bool includeMod, std::string chargeSep) const
+std::string PeptideNamespace::makeIonLabel(const PeptideNamespace::IonKey& key, const std::string& mod,
+                                           double nlMass, const std::string& chargeSep)
 {
-	std::string str = std::string(1, _b_y);
-	str += isM() ? "" : std::to_string(_num); //add ion number if not M ion
-	str += includeMod ? _mod : ""; //add modification
+	std::string str = std::string(1, ionTypeToBY(key.getIonType()));
+	str += key.isM() ? "" : std::to_string(key.getNum()); //add ion number if not M ion
+	str += mod; //add modification
 	
-	if(charge > 1)
-		str += chargeSep + makeChargeLable();
-	if(isNL())
-		str += getNLStr();
+	if(key.getCharge() > 1)
+		str += chargeSep + Ion::makeChargeLable(key.getCharge());
+	if(key.isNL())
+		str += makeNLStr(key.getNumNl(), nlMass);
 	return str;
 }
 
 /**
- Format label with markup for ggplot ms2 spectrum.
+ Make label with markup for ggplot ms2 spectrum from packed ion key.
+ \param key Ion to label.
+ \param mod Modification symbols on ion.
+ \param nlMass Mass of a single neutral loss.
  \return formatted ion label
  */
-std::string PeptideNamespace::FragmentIon::getFormatedLabel() const
+std::string PeptideNamespace::makeFormatedIonLabel(const PeptideNamespace::IonKey& key, const std::string& mod,
+                                                   double nlMass)
 {
-	std::string str = std::string(1, _b_y) + (isM() ? "" : "[" + std::to_string(_num) + "]");
+	std::string str = std::string(1, ionTypeToBY(key.getIonType())) + (key.isM() ? "" : "[" + std::to_string(key.getNum()) + "]");
 	
-	if(!_mod.empty())
-		str += " *\"" + _mod + "\"";
+	if(key.getNumMod() > 0)
+		str += " *\"" + mod + "\"";
 	
-	if(charge > 1)
-		str += "^\"" + makeChargeLable() + "\"";
+	if(key.getCharge() > 1)
+		str += "^\"" + Ion::makeChargeLable(key.getCharge()) + "\"";
 	
-	if(isNL())
-		str += getNLStr();
+	if(key.isNL())
+		str += makeNLStr(key.getNumNl(), nlMass);
 	
 	return str;
 }
 
+/**
+ Get ion label.
+ \return unformatted ion label
+ */
+std::string PeptideNamespace::FragmentIon::getLabel(bool includeMod, std::string chargeSep) const{
+	return makeIonLabel(getKey(), includeMod ? getMod() : "", _frags().nlMass, chargeSep);
+}
+
+/**
+ Format label with markup for ggplot ms2 spectrum.
+ \return formatted ion label
+ */
+std::string PeptideNamespace::FragmentIon::getFormatedLabel() const{
+	return makeFormatedIonLabel(getKey(), getMod(), _frags().nlMass);
+}
+
+void PeptideNamespace::FragmentArrays::clear()
+{
+	mass.clear();
+	mz.clear();
+	ionType.clear();
+	num.clear();
+	charge.clear();
+	beg.clear();
+	end.clear();
+	nMod.clear();
+	numNl.clear();
+	includeLabel.clear();
+	nlMass = 0;
+}
+
+void PeptideNamespace::FragmentArrays::reserve(size_t n)
+{
+	mass.reserve(n);
+	mz.reserve(n);
+	ionType.reserve(n);
+	num.reserve(n);
+	charge.reserve(n);
+	beg.reserve(n);
+	end.reserve(n);
+	nMod.reserve(n);
+	numNl.reserve(n);
+	includeLabel.reserve(n);
+}
+
+/**
+ Add a fragment which should be labeled.
+ \param _ionType Fragment ion type.
+ \param _num Fragment ion number.
+ \param _charge Fragment charge.
+ \param _mass Mass used to calculate mz.
+ \param _beg Index of first residue of fragment in peptide sequence.
+ \param _end Index of last residue of fragment in peptide sequence.
+ \param _nMod Number of dynamic modifications on fragment.
+ \param _numNl Multiple of neutral loss mass on fragment.
+ */
+void PeptideNamespace::FragmentArrays::add(IonType _ionType, int _num, int _charge, double _mass,
+										   size_t _beg, size_t _end, size_t _nMod, size_t _numNl)
+{
+	mass.push_back(_mass);
+	//b ions do not have the proton of the y ion mass
+	if(_ionType == IonType::B || _ionType == IonType::B_NL)
+		mz.push_back((_mass + ((_charge - 1) * PeptideNamespace::H_MASS)) / _charge);
+	else mz.push_back(calcMZ(_mass, _charge));
+	ionType.push_back(_ionType);
+	num.push_back(std::uint16_t(_num));
+	charge.push_back(std::int8_t(_charge));
+	beg.push_back(std::uint16_t(_beg));
+	end.push_back(std::uint16_t(_end));
+	nMod.push_back(std::uint16_t(_nMod));
+	numNl.push_back(std::uint16_t(_numNl));
+	includeLabel.push_back(true);
+}
+
+/**
+ Remove fragments without changing the order of the rest.
+ \param remove Should the fragment at each index be removed?
+ */
+void PeptideNamespace::FragmentArrays::remove(const std::vector<bool>& remove)
+{
+	size_t n = 0;
+	size_t len = size();
+	for(size_t i = 0; i < len; i++)
+	{
+		if(remove[i]) continue;
+		mass[n] = mass[i];
+		mz[n] = mz[i];
+		ionType[n] = ionType[i];
+		num[n] = num[i];
+		charge[n] = charge[i];
+		beg[n] = beg[i];
+		end[n] = end[i];
+		nMod[n] = nMod[i];
+		numNl[n] = numNl[i];
+		includeLabel[n] = includeLabel[i];
+		n++;
+	}
+	mass.resize(n);
+	mz.resize(n);
+	ionType.resize(n);
+	num.resize(n);
+	charge.resize(n);
+	beg.resize(n);
+	end.resize(n);
+	nMod.resize(n);
+	numNl.resize(n);
+	includeLabel.resize(n);
+}
+
+/**
+ \brief Calculate b, y and M ions for each charge from \p minCharge to \p maxCharge. <br>
+
+ Residue masses and modification counts are summed once into prefix and suffix
+ arrays, so the mass and modifications of each fragment are found in constant time.
+
+ \param minCharge Minimum fragment charge.
+ \param maxCharge Maximum fragment charge.
+ \param aminoAcidsMasses Used to get terminal masses.
+ */
 void PeptideNamespace::Peptide::calcFragments(int minCharge, int maxCharge,
 											  const aaDB::AADB& aminoAcidsMasses)
 {
-	fragments.clear();
-	
-//	if(sequence == "GPDFGYVTR")
-//		std::cout << "Found!" << std::endl;
-	
 	double nTerm = aminoAcidsMasses.getMW("N_term");
 	double cTerm = aminoAcidsMasses.getMW("C_term");
 	
-	const PeptideNamespace::PepIonIt endIt = aminoAcids.end();
-	const PeptideNamespace::PepIonIt begIt = aminoAcids.begin();
-	size_t beg_end, end_beg;
-	
 	size_t len = aminoAcids.size();
+	std::shared_ptr<FragmentArrays> ladder = std::make_shared<FragmentArrays>();
+	if(len == 0 || maxCharge < minCharge){
+		setFragments(ladder);
+		return;
+	}
+	
+	//prefixMass[i] is the mass of the first i residues and suffixMass[i] the mass of residues i to len
+	std::vector<double> prefixMass(len + 1, 0);
+	std::vector<double> suffixMass(len + 1, 0);
+	//prefixMods[i] is the number of dynamic modifications in the first i residues
+	std::vector<size_t> prefixMods(len + 1, 0);
 	for(size_t i = 0; i < len; i++)
 	{
-		beg_end = i + 1;
-		end_beg = i;
-		
-		std::string modsB = PeptideNamespace::concatMods(begIt, begIt + beg_end);
-		std::string modsY = PeptideNamespace::concatMods(begIt + end_beg, endIt);
-		
-		std::string ySeq = "";
-		std::string bSeq = "";
+		prefixMass[i + 1] = prefixMass[i] + aminoAcids[i].getTotalMass();
+		prefixMods[i + 1] = prefixMods[i] + (aminoAcids[i].hasDynamicMod() ? 1 : 0);
+	}
+	for(size_t i = len; i > 0; i--)
+		suffixMass[i - 1] = suffixMass[i] + aminoAcids[i - 1].getTotalMass();
+	
+	ladder->reserve(len * size_t(maxCharge - minCharge + 1) * 2);
+	for(size_t i = 0; i < len; i++)
+	{
+		double bMass = prefixMass[i + 1] + nTerm;
+		double yMass = suffixMass[i] + PeptideNamespace::H_MASS + cTerm;
+		size_t modsB = prefixMods[i + 1];
+		size_t modsY = prefixMods[len] - prefixMods[i];
 		
 		for(int j = minCharge; j <= maxCharge; j++)
 		{
 			//add b ion
-			fragments.push_back(FragmentIon('b', //b_y
-											i + 1, //num
-											j, //charge
-											PeptideNamespace::calcMass(begIt, begIt + beg_end) + nTerm, //mass
-											modsB, //mod
-											sequence) //pepSequence
-								);
+			ladder->add(IonType::B, int(i + 1), j, bMass, 0, i, modsB);
 			
 			//add y ion
-			if(i == 0){
-				fragments.push_back(FragmentIon('M', //b_y
-												0, //num
-												j, //charge
-												PeptideNamespace::calcMass(begIt + end_beg, endIt) + PeptideNamespace::H_MASS + cTerm, //mass
-												modsY, //mod
-												sequence) //pepSequence
-									);
-			}
-			else{
-				fragments.push_back(FragmentIon('y', //b_y
-												int(sequence.length() - i), //num
-												j, //charge
-												PeptideNamespace::calcMass(begIt + end_beg, endIt) + PeptideNamespace::H_MASS + cTerm, //mass
-												modsY ,//mod
-												sequence) //pepSequence
-									);
-			}//end of else
+			if(i == 0)
+				ladder->add(IonType::M, 0, j, yMass, 0, len - 1, modsY);
+			else ladder->add(IonType::Y, int(len - i), j, yMass, i, len - 1, modsY);
 		}//end of for j
-	}//enf of for i
+	}//end of for i
+	setFragments(ladder);
+}
+
+/**
+ Replace fragment ladder with \p _fragments and mark every fragment as not found.
+ \param _fragments New fragment ladder.
+ */
+void PeptideNamespace::Peptide::setFragments(std::shared_ptr<const FragmentArrays> _fragments)
+{
+	fragments = std::move(_fragments);
+	size_t len = fragments->size();
+	found.assign(len, false);
+	foundMZ.assign(len, 0);
+	foundIntensity.assign(len, 0);
+}
+
+/**
+ Remove fragments without changing the order of the rest. <br>
+ The fragment ladder is copied first because it may be shared with other Peptides.
+ \param remove Should the fragment at each index be removed?
+ */
+void PeptideNamespace::Peptide::removeFragments(const std::vector<bool>& remove)
+{
+	std::shared_ptr<FragmentArrays> ladder = std::make_shared<FragmentArrays>(*fragments);
+	ladder->remove(remove);
 	
-	/*if(sequence == "DLAAFDKSHDQAVRTYQEHK"){
-		std::cout << NEW_LINE << NEW_LINE;
-		std::streamsize ss = std::cout.precision();
-		std::cout.precision(5);
-		for(int i = minCharge; i <= maxCharge; i++)
-		{
-			for(auto it = fragments.begin(); it != fragments.end(); ++it)
-			{
-				if(it->getCharge() == i)
-				{
-					std::cout << it->getLabel(false, "_") <<
-					'\t' << std::fixed << it->getMZ() << '\t';
-					++it;
-					std::cout << std::fixed << it->getLabel(false, "_") <<
-					'\t' << it->getMZ() << '\n';
-				}
-			}
-		}
-		std::cout.precision(ss);
-		std::cout << "POOP" << NEW_LINE;
-	}*/
+	size_t n = 0;
+	size_t len = found.size();
+	for(size_t i = 0; i < len; i++)
+	{
+		if(remove[i]) continue;
+		found[n] = found[i];
+		foundMZ[n] = foundMZ[i];
+		foundIntensity[n] = foundIntensity[i];
+		n++;
+	}
+	found.resize(n);
+	foundMZ.resize(n);
+	foundIntensity.resize(n);
+	fragments = ladder;
 }
 
 /**
@@ -308,72 +454,6 @@ size_t PeptideNamespace::Peptide::nModsInSpan(size_t beg, size_t end) const
 	return ret;
 }
 
-/**
- Create a new FragmentIon object with the corresponding \p lossMass neutral loss.
- 
- \param lossMass Mass of neutral loss given as a positive number.
- \param numNL Multlipicity of neutral loss.
- \return New PeptideNamespace::FragmentIon with specified \p lossMass.
- */
-PeptideNamespace::FragmentIon PeptideNamespace::FragmentIon::makeNLFrag(double lossMass,
-																		size_t numNL) const
-{
-	PeptideNamespace::FragmentIon ret = FragmentIon(*this);
-	
-	//get new fragment type
-	PeptideNamespace::IonType ionType;
-	if(getBY() == 'b')
-		ionType = PeptideNamespace::IonType::B_NL;
-	else if(getBY() == 'y')
-		ionType = PeptideNamespace::IonType::Y_NL;
-	else if(getBY() == 'M' || getBY() == 'm')
-		ionType = PeptideNamespace::IonType::M_NL;
-	else throw std::runtime_error("Unknown ion type!");
-	ret.setIonType(ionType);
-	
-	//add mass and nlMass
-	ret.mass = mass - (lossMass / charge);
-	ret._nlMass = -1 * lossMass;
-	ret._numNl = numNL;
-
-	return ret;
-}
-
-PeptideNamespace::FragmentIon::FragmentIon(char b_y, int num, int charge, double mass, std::string mod,
-                                           const std::string &pepSequence) : Ion() {
-    _b_y = b_y;
-    _num = num;
-    _mod = mod;
-    _nlMass = 0;
-    _numNl = 0;
-    initalizeFromMass(mass, charge);
-    _found = false;
-    _ionType = strToIonType(b_y);
-    _initFragSpan(pepSequence);
-    _includeLabel = true;
-    _foundMZ = 0;
-    _foundIntensity = 0;
-}
-
-//!copy constructor
-PeptideNamespace::FragmentIon::FragmentIon(const PeptideNamespace::FragmentIon &rhs) : Ion(rhs) {
-    _b_y = rhs._b_y;
-    _num = rhs._num;
-    _mod = rhs._mod;
-    _found = rhs._found;
-    _ionType = rhs._ionType;
-    _nlMass = rhs._nlMass;
-    _numNl = rhs._numNl;
-    charge = rhs.charge;
-    mass = rhs.mass;
-    _sequence = rhs._sequence;
-    _beg = rhs._beg;
-    _end = rhs._end;
-    _includeLabel = rhs._includeLabel;
-    _foundMZ = rhs._foundMZ;
-    _foundIntensity = rhs._foundIntensity;
-}
-
 /**
  \brief Add neutral loss fragment ions to Peptide <br>
  Neutral loss ions for each b and y ion are added to Peptide for
@@ -384,27 +464,48 @@ PeptideNamespace::FragmentIon::FragmentIon(const PeptideNamespace::FragmentIon &
  */
 void PeptideNamespace::Peptide::addNeutralLoss(double lossMass, bool labelDecoyNL)
 {
+	if(!fragments)
+		throw std::runtime_error("Fragments must be calculated before adding neutral losses!");
+	
+	//the ladder is copied because it may be shared with other Peptides
+	std::shared_ptr<FragmentArrays> ladder = std::make_shared<FragmentArrays>(*fragments);
+	ladder->nlMass = lossMass;
+	
 	//calculate neutral loss combinations
 	std::vector<double> neutralLossIons;
 	for(int i = 1; i <= nMod; i++)
 		neutralLossIons.push_back(i * lossMass);
 	
-	size_t len = fragments.size();
+	size_t len = ladder->size();
 	size_t nLosses = neutralLossIons.size();
+	ladder->reserve(len * (nLosses + 1));
 	for(size_t i = 0; i < len; i++)
 	{
+		//get new fragment type
+		PeptideNamespace::IonType ionType;
+		if(ladder->ionType[i] == IonType::B)
+			ionType = PeptideNamespace::IonType::B_NL;
+		else if(ladder->ionType[i] == IonType::Y)
+			ionType = PeptideNamespace::IonType::Y_NL;
+		else if(ladder->ionType[i] == IonType::M)
+			ionType = PeptideNamespace::IonType::M_NL;
+		else throw std::runtime_error("Unknown ion type!");
+		
+		int charge = ladder->charge[i];
 		for(size_t j = 0; j < nLosses; j++)
 		{
-			fragments.push_back(fragments[i].makeNLFrag(neutralLossIons[j], j + 1));
+			ladder->add(ionType, ladder->num[i], charge,
+						  ladder->mass[i] - (neutralLossIons[j] / charge),
+						  ladder->beg[i], ladder->end[i], ladder->nMod[i], j + 1);
 			
 			//calc forceLabel
 			if(!labelDecoyNL){
-				size_t modCount_temp = nModsInSpan(fragments.back().getBegin(), fragments.back().getEnd());
-				bool forceLabel = (modCount_temp == fragments.back().getNumNl());
-				fragments.back().setForceLabel(forceLabel);
+				size_t modCount_temp = nModsInSpan(ladder->beg[i], ladder->end[i]);
+				ladder->includeLabel.back() = (modCount_temp == j + 1);
 			}//end if
 		}//end for j
 	}//end for i
+	setFragments(ladder);
 }//end function
 
 /**
@@ -538,6 +639,102 @@ void PeptideNamespace::Peptide::initialize(const base::ParamsBase& pars,
 		calcFragments(pars.getMinFragCharge(), pars.getMaxFragCharge(), aadb);
 }
 
+/**
+ \brief Initialize Peptide and calculate fragments with neutral losses, or copy them from \p cache. <br>
+ 
+ If an equivalent Peptide is in \p cache, its residues and fragment ladder are shared with
+ this Peptide instead of being calculated again. Otherwise this Peptide is added to \p cache.
+ Each Peptide keeps its own Peptide::_id and found fragments.
+ 
+ \param pars Params to get fragment charge range from.
+ \param aadb Initialized amino acid masses.
+ \param cache Cache of initialized Peptides.
+ \param calcNL Should neutral loss fragments be added?
+ \param nlMass Mass of neutral loss.
+ \param labelDecoyNL Should artifact neutral loss ions be labeled in spectra?
+ */
+void PeptideNamespace::Peptide::initialize(const base::ParamsBase& pars, const aaDB::AADB& aadb,
+										   LadderCache& cache, bool calcNL, double nlMass, bool labelDecoyNL)
+{
+	if(!cache.enabled()){
+		initialize(pars, aadb);
+		if(calcNL) addNeutralLoss(nlMass, labelDecoyNL);
+		return;
+	}
+	
+	std::string key = LadderCache::makeKey(fullSequence, pars.getMinFragCharge(), pars.getMaxFragCharge(),
+										   calcNL, nlMass, labelDecoyNL, aadb);
+	std::shared_ptr<const Peptide> cached = cache.find(key);
+	if(cached){
+		std::uint64_t id = _id;
+		*this = *cached;
+		_id = id;
+		return;
+	}
+	
+	initialize(pars, aadb);
+	if(calcNL) addNeutralLoss(nlMass, labelDecoyNL);
+	cache.insert(key, *this);
+}
+
+/**
+ Make the key for a Peptide in a LadderCache.
+ \param fullSequence Sequence with modifications.
+ \param minCharge Minimum fragment charge.
+ \param maxCharge Maximum fragment charge.
+ \param calcNL Are neutral loss fragments added?
+ \param nlMass Mass of neutral loss.
+ \param labelDecoyNL Are artifact neutral loss ions labeled?
+ \param aadb Amino acid masses used to calculate fragments.
+ \return Cache key.
+ */
+std::string PeptideNamespace::LadderCache::makeKey(const std::string& fullSequence, int minCharge, int maxCharge,
+												   bool calcNL, double nlMass, bool labelDecoyNL,
+												   const aaDB::AADB& aadb)
+{
+	std::string key = fullSequence;
+	key += '\0';
+	key += std::to_string(minCharge) + '_' + std::to_string(maxCharge);
+	if(calcNL){
+		//exact bits of the mass so different losses never share a key
+		char bytes[sizeof(double)];
+		std::memcpy(bytes, &nlMass, sizeof(double));
+		key += "_nl";
+		key.append(bytes, sizeof(double));
+		key += labelDecoyNL ? '1' : '0';
+	}
+	key += '_' + std::to_string(aadb.fingerprint());
+	return key;
+}
+
+/**
+ Get cached Peptide.
+ \param key Key from LadderCache::makeKey.
+ \return Cached Peptide or nullptr if \p key is not in cache.
+ */
+std::shared_ptr<const PeptideNamespace::Peptide> PeptideNamespace::LadderCache::find(const std::string& key) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto it = _peptides.find(key);
+	if(it == _peptides.end()) return nullptr;
+	return it->second;
+}
+
+/**
+ Add a copy of \p peptide to cache. <br>
+ The copy shares its fragment ladder with \p peptide.
+ Once the cache is full, new Peptides are not added.
+ \param key Key from LadderCache::makeKey.
+ \param peptide Initialized Peptide with no found fragments.
+ */
+void PeptideNamespace::LadderCache::insert(const std::string& key, const Peptide& peptide)
+{
+	std::shared_ptr<const Peptide> copy = std::make_shared<const Peptide>(peptide);
+	std::lock_guard<std::mutex> lock(_mutex);
+	if(_peptides.size() >= _maxSize) return;
+	_peptides.emplace(key, std::move(copy));
+}
+
 /**
  Prints peptide fragments and calculated MZs to out.
  For debugging
@@ -556,13 +753,13 @@ void PeptideNamespace::Peptide::printFragments(std::ostream& out,
             out << OUT_DELIM << "foundIntensity";
         out << NEW_LINE;
     }
-	size_t len = fragments.size();
+	size_t len = getNumFragments();
 	for(size_t i = 0; i < len; i++) {
         out << i << OUT_DELIM <<
-            fragments[i].getLabel() <<
-            OUT_DELIM << fragments[i].getMZ();
+            getFragmentLabel(i) <<
+            OUT_DELIM << fragments->mz[i];
             if(printFoundIntensity)
-                out << OUT_DELIM << fragments[i].getFoundIntensity();
+                out << OUT_DELIM << foundIntensity[i];
         out << NEW_LINE;
     }
 }
@@ -573,12 +770,10 @@ void PeptideNamespace::Peptide::printFragments(std::ostream& out,
  */
 void PeptideNamespace::Peptide::removeUnlabeledFrags()
 {
-	for(auto it = fragments.begin(); it != fragments.end();)
-	{
-		if(!it->getFound())
-			fragments.erase(it);
-		else ++it;
-	}
+	std::vector<bool> remove(found.size());
+	for(size_t i = 0; i < found.size(); i++)
+		remove[i] = !found[i];
+	removeFragments(remove);
 }
 
 /**
@@ -588,25 +783,21 @@ void PeptideNamespace::Peptide::removeUnlabeledFrags()
  */
 void PeptideNamespace::Peptide::removeLabelIntensityBelow(double min_int, bool require_nl, bool remove)
 {
-    for(auto it = fragments.begin(); it != fragments.end();)
+    std::vector<bool> removed(found.size(), false);
+    for(size_t i = 0; i < found.size(); i++)
     {
-        if(it->getFoundIntensity() <= min_int)
+        if(foundIntensity[i] <= min_int)
         {
-            if(require_nl && !it->isNL()) {
-                ++it;
+            if(require_nl && !getFragment(i).isNL())
                 continue;
-            }
 
-            if(remove) {
-                fragments.erase(it);
-                continue;
-            }
-            else {
-                it->setFound(false);
-            }
+            if(remove)
+                removed[i] = true;
+            else found[i] = false;
         }
-        ++it;
     }
+    if(remove)
+        removeFragments(removed);
 }
 
 /**
@@ -615,16 +806,23 @@ void PeptideNamespace::Peptide::removeLabelIntensityBelow(double min_int, bool r
  */
 void PeptideNamespace::Peptide::normalizeLabelIntensity(double den)
 {
-    for(auto & fragment : fragments)
-        if(fragment.getFound())
-            fragment.setFoundIntensity(fragment.getFoundIntensity() / den);
+    for(size_t i = 0; i < found.size(); i++)
+        if(found[i])
+            foundIntensity[i] /= den;
 }
 
-double PeptideNamespace::calcMass(double mz, int charge){
-	return mz * charge - (charge * PeptideNamespace::H_MASS);
-}
-double PeptideNamespace::calcMZ(double mass, int charge){
-	return (mass + (charge * PeptideNamespace::H_MASS)) / charge;
+/**
+ Get dynamic modification symbol of each residue.
+ \return String the same length as the sequence with the modification symbol
+ of each residue or '\0' for residues without a dynamic modification.
+ */
+std::string PeptideNamespace::Peptide::getResidueMods() const
+{
+	std::string ret(aminoAcids.size(), '\0');
+	for(size_t i = 0; i < aminoAcids.size(); i++)
+		if(aminoAcids[i].hasDynamicMod())
+			ret[i] = aminoAcids[i].getMod();
+	return ret;
 }
 
 /**
@@ -0,0 +1,756 @@
+//
+// scanIndex.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <scanIndex.hpp>
+
+std::mutex ms2::DecodeThreads::mutex;
+unsigned int ms2::DecodeThreads::_limit = std::thread::hardware_concurrency();
+unsigned int ms2::DecodeThreads::_inUse = 0;
+
+/**
+ * Take up to \p wanted - 1 extra threads from the limit without waiting.
+ * No threads are started until the first job is run.
+ * @param wanted Number of threads the caller would like to use, including itself.
+ */
+ms2::DecodeThreads::DecodeThreads(unsigned int wanted)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        unsigned int const available = _limit > _inUse ? _limit - _inUse : 0;
+        _extra = std::min(wanted > 0 ? wanted - 1 : 0, available);
+        _inUse += _extra;
+    }
+    _nItems = 0;
+    _nextItem = 0;
+    _generation = 0;
+    _running = 0;
+    _stop = false;
+}
+
+//! Stop and join workers, then return their threads to the limit.
+ms2::DecodeThreads::~DecodeThreads()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        _stop = true;
+    }
+    jobCv.notify_all();
+    for(auto& worker : _workers)
+        worker.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    _inUse -= _extra;
+}
+
+//! Set the maximum number of extra threads used by all loads at once.
+void ms2::DecodeThreads::setLimit(unsigned int limit)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    _limit = limit;
+}
+
+/**
+ * Start running \p job for each item in [0, \p nItems) on the workers and return without waiting.
+ * wait must be called before the next job is started.
+ * @param nItems Number of items.
+ * @param job Called once for each item. Must not throw.
+ */
+void ms2::DecodeThreads::start(size_t nItems, const Job& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        if(_workers.size() < _extra) {
+            for(unsigned int i = 0; i < _extra; i++)
+                _workers.emplace_back(&DecodeThreads::workerLoop, this);
+        }
+        _job = job;
+        _nItems = nItems;
+        _nextItem = 0;
+        _running = (unsigned int)_workers.size();
+        _generation++;
+    }
+    jobCv.notify_all();
+}
+
+//! Help with the current job on the calling thread, then wait for the workers to finish it.
+void ms2::DecodeThreads::wait()
+{
+    runItems();
+    std::unique_lock<std::mutex> lock(jobMutex);
+    doneCv.wait(lock, [this]() -> bool { return _running == 0; });
+}
+
+//! Run items from the current job until there are none left.
+void ms2::DecodeThreads::runItems()
+{
+    for(size_t i = _nextItem++; i < _nItems; i = _nextItem++)
+        _job(i);
+}
+
+void ms2::DecodeThreads::workerLoop()
+{
+    uint64_t generation = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobCv.wait(lock, [this, generation]() -> bool { return _stop || _generation != generation; });
+            if(_stop) return;
+            generation = _generation;
+        }
+        runItems();
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            if(--_running > 0) continue;
+        }
+        doneCv.notify_all();
+    }
+}
+
+/**
+ * Get the value of the attribute \p name from the XML tag in \p text between \p begin and \p end.
+ * @param text Text containing tag.
+ * @param begin Beginning of tag.
+ * @param end End of tag.
+ * @param name Attribute name.
+ * @param value Set to attribute value.
+ * @return true if the attribute was found.
+ */
+bool ms2::getXmlAttribute(const std::string& text, size_t begin, size_t end,
+                          const std::string& name, std::string& value)
+{
+    std::string const key = " " + name + "=\"";
+    size_t pos = text.find(key, begin);
+    if(pos == std::string::npos || pos >= end) return false;
+    pos += key.size();
+    size_t valueEnd = text.find('"', pos);
+    if(valueEnd == std::string::npos || valueEnd > end) return false;
+    value = text.substr(pos, valueEnd - pos);
+    return true;
+}
+
+/**
+ * Find the first mzML cvParam with \p accession between \p begin and \p end.
+ * @param text Text to search.
+ * @param begin Beginning of range to search.
+ * @param end End of range to search.
+ * @param accession cvParam accession. (ex: "MS:1000514")
+ * @return true if the cvParam was found.
+ */
+bool ms2::hasCvParam(const std::string& text, size_t begin, size_t end, const std::string& accession)
+{
+    size_t pos = text.find("accession=\"" + accession + "\"", begin);
+    return pos != std::string::npos && pos < end;
+}
+
+/**
+ * Get the value of the first mzML cvParam with \p accession between \p begin and \p end.
+ * @param text Text to search.
+ * @param begin Beginning of range to search.
+ * @param end End of range to search.
+ * @param accession cvParam accession. (ex: "MS:1000016")
+ * @param value Set to cvParam value.
+ * @return true if the cvParam was found and has a value.
+ */
+bool ms2::getCvParam(const std::string& text, size_t begin, size_t end,
+                     const std::string& accession, std::string& value)
+{
+    size_t pos = text.find("accession=\"" + accession + "\"", begin);
+    if(pos == std::string::npos || pos >= end) return false;
+    size_t tagBegin = text.rfind('<', pos);
+    if(tagBegin == std::string::npos || tagBegin < begin) return false;
+    size_t tagEnd = std::min(text.find('>', pos), end);
+    return getXmlAttribute(text, tagBegin, tagEnd, "value", value);
+}
+
+/**
+ * Get the scan number from an mzML native id. (ex: "controllerType=0 controllerNumber=1 scan=1234")
+ * @param id Native id.
+ * @return Scan number or 0 if \p id has no scan number.
+ */
+size_t ms2::scanNumFromNativeId(const std::string& id)
+{
+    size_t pos = id.find("scan=");
+    if(pos == std::string::npos) return 0;
+    return std::strtoul(id.c_str() + pos + 5, nullptr, 10);
+}
+
+/**
+ * Get file type from the extension of \p fname.
+ * A trailing gzip extension is ignored.
+ * @param fname Path to MS file.
+ */
+ms2::ScanIndex::FileType ms2::ScanIndex::getFileType(const std::string& fname)
+{
+    std::string name = utils::toLower(fname);
+    if(name.size() > gzip::GZIP_EXT.size() &&
+       name.compare(name.size() - gzip::GZIP_EXT.size(), gzip::GZIP_EXT.size(), gzip::GZIP_EXT) == 0)
+        name.erase(name.size() - gzip::GZIP_EXT.size());
+    size_t pos = name.find_last_of('.');
+    if(pos == std::string::npos) return FileType::UNKNOWN;
+    std::string ext = name.substr(pos);
+    if(ext == ".ms2") return FileType::MS2;
+    if(ext == ".mzxml") return FileType::MZXML;
+    if(ext == ".mzml") return FileType::MZML;
+    return FileType::UNKNOWN;
+}
+
+/**
+ * Get the size and modification time of \p fname.
+ * @return false if \p fname could not be accessed.
+ */
+bool ms2::ScanIndex::getFileStats(const std::string& fname, uint64_t& size, int64_t& mtime)
+{
+    struct stat buffer;
+    if(stat(fname.c_str(), &buffer) != 0) return false;
+    size = (uint64_t)buffer.st_size;
+    mtime = (int64_t)buffer.st_mtime;
+    return true;
+}
+
+/**
+ * Parse \p fname once to find the location and precursor data of each scan.
+ * Peaks are not decoded. <br>
+ * The file is memory mapped and split into byte ranges which begin at a scan,
+ * so each range can be parsed by a different thread. Scan positions are read from
+ * the offset index at the end of indexed mzML and mzXML files when there is one,
+ * otherwise they are found by searching the file in parallel.
+ * @param fname Path to MS file.
+ * @param nThread Number of threads to use.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::ScanIndex::build(const std::string& fname, unsigned int nThread)
+{
+    DecodeThreads threads(std::max(1u, nThread));
+    return build(fname, threads);
+}
+
+/**
+ * Same as build, but the index is built with \p threads.
+ * @param fname Path to MS file.
+ * @param threads Threads to build the index with.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::ScanIndex::build(const std::string& fname, DecodeThreads& threads)
+{
+    MappedFile file;
+    if(!file.open(fname)) return false;
+    file.advise(MappedFile::Advice::SEQUENTIAL);
+    return build(fname, file.begin(), file.end(), threads);
+}
+
+/**
+ * Build the index of \p fname from its contents in memory.
+ * Used for compressed files, which are decompressed into memory before they are indexed.
+ * Offsets in the index are relative to \p begin.
+ * @param fname Path to MS file.
+ * @param begin Beginning of file contents.
+ * @param end End of file contents.
+ * @param nThread Number of threads to use.
+ * @return true if successful.
+ */
+bool ms2::ScanIndex::build(const std::string& fname, const char* begin, const char* end, unsigned int nThread)
+{
+    DecodeThreads threads(std::max(1u, nThread));
+    return build(fname, begin, end, threads);
+}
+
+/**
+ * Same as build, but the index is built with \p threads.
+ * @param fname Path to MS file.
+ * @param begin Beginning of file contents.
+ * @param end End of file contents.
+ * @param threads Threads to build the index with.
+ * @return true if successful.
+ */
+bool ms2::ScanIndex::build(const std::string& fname, const char* begin, const char* end, DecodeThreads& threads)
+{
+    _fname = fname;
+    _fileType = getFileType(fname);
+    _entries.clear();
+    if(_fileType == FileType::UNKNOWN) return false;
+    if(!getFileStats(fname, _fileSize, _fileMTime)) return false;
+    unsigned int const nThread = threads.size();
+
+    //find where each range begins
+    std::vector<uint64_t> starts;
+    if(nThread > 1 && !readOffsetIndex(_fileType, begin, end, starts))
+        findScanStarts(_fileType, begin, end, threads, starts);
+
+    //the first range also holds everything before the first scan
+    std::vector<const char*> bounds;
+    bounds.push_back(begin);
+    size_t const nRanges = std::min((size_t)nThread, starts.size());
+    for(size_t i = 1; i < nRanges; i++)
+        bounds.push_back(begin + starts[i * starts.size() / nRanges]);
+    bounds.push_back(end);
+
+    //parse each range
+    std::vector<EntryList> entries(bounds.size() - 1);
+    std::vector<char> success(entries.size(), 0);
+    threads.run(entries.size(), [&](size_t i){
+        success[i] = buildRange(_fileType, begin, bounds[i], bounds[i + 1], entries[i]);
+    });
+
+    //merge in file order
+    size_t nEntries = 0;
+    for(size_t i = 0; i < entries.size(); i++) {
+        if(!success[i]) return false;
+        nEntries += entries[i].size();
+    }
+    _entries.reserve(nEntries);
+    for(auto& range : entries)
+        std::move(range.begin(), range.end(), std::back_inserter(_entries));
+    std::stable_sort(_entries.begin(), _entries.end());
+    return true;
+}
+
+/**
+ * Parse the scans which begin between \p begin and \p end.
+ * @param fileType Type of file.
+ * @param fileBegin Beginning of the file. Offsets are relative to this.
+ * @param begin Beginning of range. Must be the beginning of a scan or the file.
+ * @param end End of range. Must be the beginning of a scan or the end of the file.
+ * @param entries Entries are added for each scan in the range.
+ * @return true if successful.
+ */
+bool ms2::ScanIndex::buildRange(FileType fileType, const char* fileBegin, const char* begin, const char* end,
+                                EntryList& entries)
+{
+    switch(fileType) {
+        case FileType::MS2: return buildMs2(fileBegin, begin, end, entries);
+        case FileType::MZXML: return buildMzXML(fileBegin, begin, end, entries);
+        case FileType::MZML: return buildMzML(fileBegin, begin, end, entries);
+        default: return false;
+    }
+}
+
+/**
+ * Read the offset of each scan from the index at the end of an indexed mzML or mzXML file.
+ * Every offset is checked to point to the beginning of a scan.
+ * @param fileType Type of file.
+ * @param begin Beginning of file.
+ * @param end End of file.
+ * @param starts Populated with the offset of each scan in the order they appear in the file.
+ * @return false if the file has no offset index or the index is not valid.
+ */
+bool ms2::ScanIndex::readOffsetIndex(FileType fileType, const char* begin, const char* end,
+                                     std::vector<uint64_t>& starts)
+{
+    starts.clear();
+    std::string indexName, scanTag;
+    if(fileType == FileType::MZML) {
+        indexName = "<index name=\"spectrum\"";
+        scanTag = "<spectrum ";
+    }
+    else if(fileType == FileType::MZXML) {
+        indexName = "<index name=\"scan\"";
+        scanTag = "<scan ";
+    }
+    else return false;
+
+    //<indexOffset> is near the end of the file
+    size_t const size = (size_t)(end - begin);
+    size_t const tailSize = std::min(size, (size_t)4096);
+    std::string const tail(end - tailSize, end);
+    size_t pos = tail.rfind("<indexOffset>");
+    if(pos == std::string::npos) return false;
+    uint64_t const indexOffset = std::strtoull(tail.c_str() + pos + 13, nullptr, 10);
+    if(indexOffset == 0 || indexOffset >= size) return false;
+
+    std::string const index(begin + indexOffset, end);
+    size_t indexBegin = index.find(indexName);
+    if(indexBegin == std::string::npos) return false;
+    size_t const indexEnd = index.find("</index>", indexBegin);
+    if(indexEnd == std::string::npos) return false;
+
+    pos = indexBegin;
+    while((pos = index.find("<offset", pos)) != std::string::npos && pos < indexEnd) {
+        pos = index.find('>', pos);
+        if(pos == std::string::npos) return false;
+        uint64_t offset = std::strtoull(index.c_str() + pos + 1, nullptr, 10);
+        if(offset + scanTag.size() > size || std::memcmp(begin + offset, scanTag.c_str(), scanTag.size()) != 0) {
+            starts.clear();
+            return false;
+        }
+        starts.push_back(offset);
+    }
+    std::sort(starts.begin(), starts.end());
+    return !starts.empty();
+}
+
+/**
+ * Find the offset of each scan by searching for the tag or line which begins a scan.
+ * The file is split into a piece for each thread in \p threads and the pieces are searched at the same time.
+ * @param fileType Type of file.
+ * @param begin Beginning of file.
+ * @param end End of file.
+ * @param threads Threads to search with.
+ * @param starts Populated with the offset of each scan in the order they appear in the file.
+ */
+void ms2::ScanIndex::findScanStarts(FileType fileType, const char* begin, const char* end,
+                                    DecodeThreads& threads, std::vector<uint64_t>& starts)
+{
+    starts.clear();
+    //.ms2 scans begin with an S line
+    std::string const pattern = fileType == FileType::MZML ? "<spectrum " :
+                                fileType == FileType::MZXML ? "<scan " : "\nS\t";
+    size_t const skip = fileType == FileType::MS2 ? 1 : 0;
+    size_t const size = (size_t)(end - begin);
+
+    std::vector<std::vector<uint64_t> > found(threads.size());
+    threads.run(found.size(), [&](size_t i){
+        //matches which begin in this piece
+        const char* pos = begin + i * size / found.size();
+        const char* const pieceEnd = begin + (i + 1) * size / found.size();
+        const char* const searchEnd = std::min(end, pieceEnd + pattern.size() - 1);
+        while((pos = std::search(pos, searchEnd, pattern.begin(), pattern.end())) < pieceEnd) {
+            found[i].push_back((uint64_t)(pos - begin) + skip);
+            pos += pattern.size();
+        }
+    });
+
+    if(fileType == FileType::MS2 && size > 0 && *begin == 'S')
+        starts.push_back(0);
+    for(const auto& piece : found)
+        starts.insert(starts.end(), piece.begin(), piece.end());
+}
+
+bool ms2::ScanIndex::buildMs2(const char* fileBegin, const char* begin, const char* end, EntryList& entries)
+{
+    std::vector<std::string> elems;
+    bool inScan = false;
+    Entry entry;
+    const char* lineBegin = begin;
+    while(lineBegin < end) {
+        const char* lineEnd = (const char*)std::memchr(lineBegin, '\n', (size_t)(end - lineBegin));
+        if(lineEnd == nullptr) lineEnd = end;
+        uint64_t const offset = (uint64_t)(lineBegin - fileBegin);
+
+        if(*lineBegin == 'S') {
+            if(inScan) {
+                entry.length = offset - entry.offset;
+                entries.push_back(entry);
+            }
+            utils::split(std::string(lineBegin, lineEnd), '\t', elems);
+            if(elems.size() < 4) return false;
+            entry = Entry();
+            entry.offset = offset;
+            entry.scanNum = std::strtoul(elems[1].c_str(), nullptr, 10);
+            entry.precursorMZ = utils::trim(elems[3]);
+            inScan = true;
+        }
+        else if(inScan && *lineBegin == 'I') {
+            utils::split(std::string(lineBegin, lineEnd), '\t', elems);
+            if(elems.size() >= 3 && elems[1] == "RetTime")
+                entry.rt = std::atof(elems[2].c_str());
+        }
+        else if(inScan && *lineBegin == 'Z' && entry.charge == 0) {
+            utils::split(std::string(lineBegin, lineEnd), '\t', elems);
+            if(elems.size() >= 2)
+                entry.charge = std::atoi(elems[1].c_str());
+        }
+        lineBegin = lineEnd + 1;
+    }
+    if(inScan) {
+        entry.length = (uint64_t)(end - fileBegin) - entry.offset;
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+bool ms2::ScanIndex::buildMzXML(const char* fileBegin, const char* begin, const char* end, EntryList& entries)
+{
+    std::string tag;
+    std::string value;
+    bool inScan = false;
+    bool readPrecursorMZ = false;
+    Entry entry;
+
+    //read one tag at a time
+    const char* tagBegin = begin;
+    while(tagBegin < end) {
+        const char* gt = (const char*)std::memchr(tagBegin, '>', (size_t)(end - tagBegin));
+        const char* tagEnd = gt == nullptr ? end : gt + 1;
+        tag.assign(tagBegin, gt == nullptr ? end : gt);
+        uint64_t const offset = (uint64_t)(tagBegin - fileBegin);
+        tagBegin = tagEnd;
+
+        size_t lt = tag.find('<');
+        if(readPrecursorMZ) {
+            entry.precursorMZ = utils::trim(tag.substr(0, lt));
+            readPrecursorMZ = false;
+        }
+        if(lt == std::string::npos) continue;
+
+        if(tag.compare(lt, 6, "<scan ") == 0) {
+            if(inScan) {
+                entry.length = offset + lt - entry.offset;
+                entries.push_back(entry);
+            }
+            entry = Entry();
+            entry.offset = offset + lt;
+            if(getXmlAttribute(tag, lt, tag.size(), "num", value))
+                entry.scanNum = std::strtoul(value.c_str(), nullptr, 10);
+            //retention time is an xs:duration in seconds. (ex: "PT60.5S")
+            if(getXmlAttribute(tag, lt, tag.size(), "retentionTime", value)) {
+                size_t numBegin = value.find_first_of("0123456789.");
+                if(numBegin != std::string::npos)
+                    entry.rt = std::atof(value.c_str() + numBegin) / 60;
+            }
+            inScan = true;
+        }
+        else if(inScan && tag.compare(lt, 12, "<precursorMz") == 0) {
+            if(getXmlAttribute(tag, lt, tag.size(), "precursorCharge", value))
+                entry.charge = std::atoi(value.c_str());
+            readPrecursorMZ = true;
+        }
+        else if(inScan && tag.compare(lt, std::string::npos, "</scan") == 0) {
+            entry.length = (uint64_t)(tagEnd - fileBegin) - entry.offset;
+            entries.push_back(entry);
+            inScan = false;
+        }
+    }
+    //A scan which contains nested scans is ended by the first scan in the next range.
+    if(inScan) {
+        entry.length = (uint64_t)(end - fileBegin) - entry.offset;
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+bool ms2::ScanIndex::buildMzML(const char* fileBegin, const char* begin, const char* end, EntryList& entries)
+{
+    std::string tag;
+    std::string value;
+    bool inSpectrum = false;
+    bool foundPrecursorMZ = false;
+    Entry entry;
+
+    //read one tag at a time
+    const char* tagBegin = begin;
+    while(tagBegin < end) {
+        const char* gt = (const char*)std::memchr(tagBegin, '>', (size_t)(end - tagBegin));
+        const char* tagEnd = gt == nullptr ? end : gt + 1;
+        tag.assign(tagBegin, gt == nullptr ? end : gt);
+        uint64_t const offset = (uint64_t)(tagBegin - fileBegin);
+        tagBegin = tagEnd;
+
+        size_t lt = tag.find('<');
+        if(lt == std::string::npos) continue;
+
+        if(tag.compare(lt, 10, "<spectrum ") == 0) {
+            entry = Entry();
+            entry.offset = offset + lt;
+            if(getXmlAttribute(tag, lt, tag.size(), "id", value))
+                entry.scanNum = scanNumFromNativeId(value);
+            if(entry.scanNum == 0 && getXmlAttribute(tag, lt, tag.size(), "index", value))
+                entry.scanNum = std::strtoul(value.c_str(), nullptr, 10) + 1;
+            foundPrecursorMZ = false;
+            inSpectrum = true;
+        }
+        else if(inSpectrum && tag.compare(lt, 8, "<cvParam") == 0) {
+            //scan start time
+            if(getCvParam(tag, lt, tag.size(), "MS:1000016", value)) {
+                entry.rt = std::atof(value.c_str());
+                std::string unit;
+                if(getXmlAttribute(tag, lt, tag.size(), "unitAccession", unit) && unit == "UO:0000010")
+                    entry.rt /= 60;
+            }
+            //selected ion m/z
+            else if(!foundPrecursorMZ && getCvParam(tag, lt, tag.size(), "MS:1000744", value)) {
+                entry.precursorMZ = value;
+                foundPrecursorMZ = true;
+            }
+            //charge state
+            else if(entry.charge == 0 && getCvParam(tag, lt, tag.size(), "MS:1000041", value))
+                entry.charge = std::atoi(value.c_str());
+        }
+        else if(inSpectrum && tag.compare(lt, std::string::npos, "</spectrum") == 0) {
+            entry.length = (uint64_t)(tagEnd - fileBegin) - entry.offset;
+            entries.push_back(entry);
+            inSpectrum = false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Read the sidecar index for \p fname.
+ * @param fname Path to MS file.
+ * @return false if the sidecar does not exist, can not be parsed,
+ * or was built from a different version of \p fname.
+ */
+bool ms2::ScanIndex::readSidecar(const std::string& fname)
+{
+    _fname = fname;
+    _fileType = getFileType(fname);
+    _entries.clear();
+
+    uint64_t fileSize = 0;
+    int64_t fileMTime = 0;
+    if(!getFileStats(fname, fileSize, fileMTime)) return false;
+
+    std::ifstream inF(sidecarName(fname));
+    if(!inF) return false;
+
+    std::string line;
+    std::vector<std::string> elems;
+
+    //header
+    if(!utils::safeGetline(inF, line)) return false;
+    utils::split(line, OUT_DELIM, elems);
+    if(elems.size() != 4 || elems[0] != SCAN_INDEX_HEADER ||
+       std::atoi(elems[1].c_str()) != SCAN_INDEX_VERSION)
+        return false;
+    _fileSize = std::strtoull(elems[2].c_str(), nullptr, 10);
+    _fileMTime = std::strtoll(elems[3].c_str(), nullptr, 10);
+    if(_fileSize != fileSize || _fileMTime != fileMTime)
+        return false;
+
+    //entries
+    while(utils::safeGetline(inF, line)) {
+        if(line.empty()) continue;
+        utils::split(line, OUT_DELIM, elems);
+        if(elems.size() != 6) {
+            _entries.clear();
+            return false;
+        }
+        Entry entry;
+        entry.scanNum = std::strtoul(elems[0].c_str(), nullptr, 10);
+        entry.offset = std::strtoull(elems[1].c_str(), nullptr, 10);
+        entry.length = std::strtoull(elems[2].c_str(), nullptr, 10);
+        entry.precursorMZ = elems[3];
+        entry.rt = std::atof(elems[4].c_str());
+        entry.charge = std::atoi(elems[5].c_str());
+        _entries.push_back(entry);
+    }
+    std::stable_sort(_entries.begin(), _entries.end());
+    return true;
+}
+
+/**
+ * Write the index to its sidecar file. <br>
+ * The index is written to a temporary file which is then renamed so other processes
+ * never see a partially written index.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::ScanIndex::writeSidecar() const
+{
+    std::string const ofname = sidecarName(_fname);
+    std::string const tempName = ofname + ".tmp";
+    std::ofstream outF(tempName);
+    if(!outF) return false;
+
+    outF << SCAN_INDEX_HEADER << OUT_DELIM << SCAN_INDEX_VERSION
+         << OUT_DELIM << _fileSize << OUT_DELIM << _fileMTime << NEW_LINE;
+    outF << std::setprecision(10);
+    for(const auto& entry : _entries) {
+        outF << entry.scanNum << OUT_DELIM << entry.offset << OUT_DELIM << entry.length
+             << OUT_DELIM << entry.precursorMZ << OUT_DELIM << entry.rt
+             << OUT_DELIM << entry.charge << NEW_LINE;
+    }
+    outF.close();
+    if(!outF || std::rename(tempName.c_str(), ofname.c_str()) != 0) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Read the sidecar index for \p fname if it is up to date.
+ * Otherwise build the index and write a new sidecar.
+ * If the sidecar can not be written the index is still usable for this run.
+ * @param fname Path to MS file.
+ * @param nThread Number of threads used to build the index.
+ * @return true if the index was successfully read or built.
+ */
+bool ms2::ScanIndex::load(const std::string& fname, unsigned int nThread)
+{
+    DecodeThreads threads(std::max(1u, nThread));
+    return load(fname, threads);
+}
+
+/**
+ * Same as load, but if the index has to be built it is built with \p threads.
+ * @param fname Path to MS file.
+ * @param threads Threads used to build the index.
+ * @return true if the index was successfully read or built.
+ */
+bool ms2::ScanIndex::load(const std::string& fname, DecodeThreads& threads)
+{
+    if(readSidecar(fname)) return true;
+    if(!build(fname, threads)) return false;
+    if(!writeSidecar())
+        std::cerr << "\n\tWarning: Could not write scan index: " << sidecarName(fname) << NEW_LINE;
+    return true;
+}
+
+/**
+ * Same as load, but if the index has to be built it is built from the contents of \p fname in memory.
+ * @param fname Path to MS file.
+ * @param begin Beginning of file contents.
+ * @param end End of file contents.
+ * @param nThread Number of threads used to build the index.
+ * @return true if the index was successfully read or built.
+ */
+bool ms2::ScanIndex::load(const std::string& fname, const char* begin, const char* end, unsigned int nThread)
+{
+    DecodeThreads threads(std::max(1u, nThread));
+    return load(fname, begin, end, threads);
+}
+
+/**
+ * Same as load, but if the index has to be built it is built from the contents of \p fname in memory with \p threads.
+ * @param fname Path to MS file.
+ * @param begin Beginning of file contents.
+ * @param end End of file contents.
+ * @param threads Threads used to build the index.
+ * @return true if the index was successfully read or built.
+ */
+bool ms2::ScanIndex::load(const std::string& fname, const char* begin, const char* end, DecodeThreads& threads)
+{
+    if(readSidecar(fname)) return true;
+    if(!build(fname, begin, end, threads)) return false;
+    if(!writeSidecar())
+        std::cerr << "\n\tWarning: Could not write scan index: " << sidecarName(fname) << NEW_LINE;
+    return true;
+}
+
+/**
+ * Find the entry for \p scanNum.
+ * @param scanNum Scan number.
+ * @return Pointer to entry or nullptr if \p scanNum is not in the index.
+ */
+const ms2::ScanIndex::Entry* ms2::ScanIndex::find(size_t scanNum) const
+{
+    Entry key;
+    key.scanNum = scanNum;
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), key);
+    if(it == _entries.end() || it->scanNum != scanNum) return nullptr;
+    return &(*it);
+}
@@ -0,0 +1,89 @@
+//
+// scanSource.cpp
+// ionFinder
+// -----------------------------------------------------------------------------
+// MIT License
+// Copyright 2020 Aaron Maurais
+// -----------------------------------------------------------------------------
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// -----------------------------------------------------------------------------
+//
+
+#include <scanSource.hpp>
+#include <indexedMsFile.hpp>
+#include <mappedMs2File.hpp>
+#include <binaryCache.hpp>
+
+/**
+ * Parse \p fname with the peptideUtils reader for its file type.
+ * @param fname Path to MS file.
+ * @return true if all file I/O was successful.
+ */
+bool ms2::UtilsScanSource::read(const std::string& fname)
+{
+    MsFile::FileType fileType = MsFile::getFileType(fname);
+    if(fileType == MsFile::FileType::MS2)
+        _file.reset(new utils::msInterface::Ms2File());
+    else if(fileType == MsFile::FileType::MZXML)
+        _file.reset(new utils::msInterface::MzXMLFile());
+    else if(fileType == MsFile::FileType::MZML)
+        _file.reset(new utils::msInterface::MzMLFile());
+    else {
+        std::cerr << "Unknown file type for file " << fname << NEW_LINE;
+        return false;
+    }
+    _memory = estimateMemory(fname);
+    return _file->read(fname);
+}
+
+/**
+ * Copy a scan out of the parsed file.
+ * The peptideUtils readers keep every peak, so the peak filter is applied to the copy.
+ */
+bool ms2::UtilsScanSource::getScan(size_t scanNum, ms2::Spectrum& scan) const
+{
+    if(!_file || !_file->getScan(scanNum, scan)) return false;
+    if(_peakFilter.active())
+        scan.filterIons(_peakFilter);
+    return true;
+}
+
+/**
+ * Construct the ScanSource to use for \p fname.
+ * @param fname Path to MS file.
+ * @param options Reader options.
+ * @return Unread ScanSource.
+ */
+std::shared_ptr<ms2::ScanSource> ms2::makeScanSource(const std::string& fname, const ReaderOptions& options)
+{
+    std::shared_ptr<ms2::ScanSource> source;
+    ms2::ScanIndex::FileType fileType = ms2::ScanIndex::getFileType(fname);
+    if(options.binaryCache && ms2::BinaryCacheFile::isCurrent(fname))
+        source = std::make_shared<ms2::BinaryCacheFile>();
+    //compressed files can not be mapped or read by peptideUtils
+    else if(fileType != ms2::ScanIndex::FileType::UNKNOWN && gzip::isCompressed(fname))
+        source = std::make_shared<ms2::IndexedMsFile>(options.decodeThreads, options.scanIndex);
+    else if(options.mmap && fileType == ms2::ScanIndex::FileType::MS2)
+        source = std::make_shared<ms2::MappedMs2File>(options.scanIndex);
+    else if(options.scanIndex && fileType != ms2::ScanIndex::FileType::UNKNOWN)
+        source = std::make_shared<ms2::IndexedMsFile>(options.decodeThreads);
+    else source = std::make_shared<ms2::UtilsScanSource>();
+    source->setPeakFilter(options.peakFilter);
+    return source;
+}